@@ -32,6 +32,23 @@ A number of classes, examples and test scripts are available:\n
 \li
 \li LidarTools::GlidingAveFilter
 \li LidarTools::SavGolFilter
+\li LidarTools::ChannelRegistry
+\li LidarTools::ChannelBuffer
+\li LidarTools::LidarShot
+\li LidarTools::Arena
+\li LidarTools::PowerSums
+\li LidarTools::Inversion and LidarTools::InversionRegistry
+\li LidarTools::FernaldBatchInput and LidarTools::Fernald84Lanes
+\li LidarTools::ThreadPool
+\li LidarTools::SplitMix64
+\li LidarTools::RecurrenceErrors
+\li LidarTools::Dual
+\li LidarTools::AODTable and LidarTools::BrentRoot
+\li LidarTools::OptimalEstimationAlgorithm and LidarTools::BandLDLTFactor
+\li LidarTools::AnalysisConfig
+\li LidarTools::IntervalIndex
+\li LidarTools::SweepSpec and LidarTools::SweepRunner
+\li LidarTools::ResultCache
 
 \b Scripts
 \li test_LidarFile.C uses the Analyser to open a file and run a data analysis
@@ -45,5 +62,22 @@ A number of classes, examples and test scripts are available:\n
 \li test_Plotter.C
 \li test_Rayleigh.C
 \li test_SavGolFilter.C
+\li test_Arena.C
+\li test_PowerSums.C
+\li test_KlettKernel.C
+\li test_Inversion.C
+\li test_FastMath.C
+\li test_FernaldBatch.C
+\li test_ThreadPool.C
+\li test_RecurrenceErrors.C
+\li test_Dual.C
+\li test_AODTable.C
+\li test_BandSolver.C
+\li test_AnalysisConfig.C
+\li test_ConfigEpochs.C
+\li test_SweepSpec.C
+\li test_ResultCache.C
+\li test_AdaptiveBins.C
+\li doSweep.C processes a list of runs with every parameter set of a sweep
 
 */
@@ -0,0 +1,117 @@
+/** @file AODTable.hh
+ *
+ * @brief AODTable class definition
+ *
+ * Class to read an external aerosol optical depth table, indexed by run
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_AODTable
+#define LIDARTOOLS_AODTable
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <vector>
+#include <string>
+#include <iostream>     // std::cout
+
+namespace LidarTools {
+
+/** @class AODTable
+ *
+ * @brief Aerosol optical depths of an external instrument, indexed by run
+ *
+ * Reads a table as data/All_runs_Modis_data_08022017.txt, one run per line:
+ * run, date, time, then two MODIS observations, each with its time
+ * difference to the run in hours, separation, aerosol type, cloud fraction,
+ * Deep Blue AOD at 550 nm and Angstrom exponent. Missing values are -9999.
+ * Lines that do not start with a run number are skipped.
+ *
+ * The table is read once and sorted by run, a look up is a binary search.
+ *
+ * @see Analyser::doSolveSp
+*/
+  class AODTable
+  {
+
+  public:
+    /** @brief class constructor
+     *
+     * @param verbose a boolean for verbosity
+     */
+    AODTable(Bool_t verbose=false);
+
+    /** @brief class destructor
+     *
+    */
+    virtual ~AODTable() {}
+
+    /** @brief Remove all runs */
+    void Reset();
+
+    /** @brief Read a table from an ascii file, replaces the current runs
+     *
+     * @param filename the table file name
+     * @return 0 if OK, 1 if the file could not be opened
+    */
+    int Read(std::string filename);
+
+    /** @brief Set verbosity on or off
+     *
+     * @param verbose a bool, true or false
+     */
+    void SetVerbose(Bool_t verbose) {fVerbose=verbose;}
+
+    /** @brief Returns the number of runs in the table */
+    Int_t GetNRuns() const {return fEntries.size();}
+
+    /** @brief Get the AOD of a run at a given wavelength
+     *
+     * Takes the valid observation nearest in time to the run, and scales
+     * its AOD at 550 nm with its Angstrom exponent:
+     * AOD(wl)=AOD(550)*(wl/550)^-Angstrom
+     *
+     * @param run the run number
+     * @param wl the wavelength as an integer
+     * @param maxHours the largest time difference between run and observation, in hours
+     * @param aod the AOD at wl
+     * @return 0 if OK, 1 for an unknown run, 2 if no valid observation is close enough
+    */
+    int GetAOD(Int_t run, Int_t wl, Float_t maxHours, Float_t& aod) const;
+
+  private:
+    /** @brief One run of the table */
+    struct Entry
+    {
+      /** @brief Run number */
+      Int_t   fRun;
+      /** @brief Time difference of each observation to the run, in hours */
+      Float_t fDHours[2];
+      /** @brief AOD at 550 nm of each observation */
+      Float_t fAOD[2];
+      /** @brief Angstrom exponent of each observation */
+      Float_t fAngstrom[2];
+      /** @brief Order by run number */
+      bool operator<(const Entry& b) const {return fRun<b.fRun;}
+    };
+
+    /** @brief boolean to print some results if true */
+    Bool_t fVerbose;
+
+    /** @brief Runs, sorted by run number */
+    std::vector<Entry> fEntries; //!
+
+  protected:
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+    ClassDef(LidarTools::AODTable,1);
+#endif
+
+  }; // class
+
+}; // namespace
+
+#endif
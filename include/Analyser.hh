@@ -20,13 +20,23 @@
 
 #include <map>
 #include <ctime>
+#include <cmath>
+#include <string>
 
 #include "Overlap.hh"
 #include "ConfigHandler.hh"
+#include "AnalysisConfig.hh"
 #include "AtmoProfile.hh"
 #include "AtmoAbsorption.hh"
-#include "GlidingAveFilter.hh"
+#include "PowerSums.hh"
+#include "Inversion.hh"
+#include "OpacityKernel.hh"
+#include "FernaldBatch.hh"
 #include "SavGolFilter.hh"
+#include "ChannelRegistry.hh"
+#include "ChannelBuffer.hh"
+#include "LidarShot.hh"
+#include "Arena.hh"
 
 /** @namespace LidarTools
  *
@@ -34,6 +44,299 @@
  * 
 */
 namespace LidarTools {
+
+/** @struct ChannelParams
+ *
+ * @brief Per channel inversion parameters
+ *
+ * Read from the configuration keys R0_wl, Fernald_Spwl and AlignCorr_wl,
+ * R0 and AlignCorr may be changed by the optimization.
+ */
+  struct ChannelParams
+  {
+    /** @brief Reference altitude */
+    Float_t fR0;
+    /** @brief Sp=alpha_p/beta_p extinction-to-backscatter ratio */
+    Float_t fSp;
+    /** @brief Mis-Alignment correction factor */
+    Float_t fAlignCorr;
+  };
+
+/** @struct PreScanStats
+ *
+ * @brief Raw signal statistics, from the fused pre-scan of one channel
+ *
+ * @see Analyser::PreScan
+ */
+  struct PreScanStats
+  {
+    /** @brief Reset all statistics */
+    void Reset() {
+      fDone=false; fMin=999.;
+      fBkgSum=0; fBkgSumSq=0; fBkgCount=0; fBkgSlope=0;
+      fNSaturated=0; fNClipped=0;
+      }
+    /** @brief Mean of the raw signal in the background window */
+    Float_t GetBkgMean() const {return fBkgCount>0 ? fBkgSum/fBkgCount : 0;}
+    /** @brief RMS of the raw signal in the background window */
+    Float_t GetBkgRMS() const {
+      if(fBkgCount<2) return 0;
+      Double_t mean=fBkgSum/fBkgCount;
+      Double_t var=(fBkgSumSq-fBkgCount*mean*mean)/(fBkgCount-1);
+      return var>0 ? sqrt(var) : 0;
+      }
+    /** @brief True once the pre-scan has been run for this shot */
+    Bool_t   fDone;
+    /** @brief Minimum of the raw trace, -5 V expected for good data */
+    Float_t  fMin;
+    /** @brief Sum of the raw signal in the background window */
+    Double_t fBkgSum;
+    /** @brief Sum of squares of the raw signal in the background window */
+    Double_t fBkgSumSq;
+    /** @brief Number of samples in the background window */
+    Int_t    fBkgCount;
+    /** @brief Least squares slope of the raw signal in the background window, in V/km */
+    Float_t  fBkgSlope;
+    /** @brief Number of samples of the trace at or below the quality threshold */
+    Int_t    fNSaturated;
+    /** @brief Number of samples of the analysis window in runs of at least
+     *  ClassifyClipRun consecutive samples at the trace minimum, the ADC rail */
+    Int_t    fNClipped;
+  };
+
+/** @struct Layer
+ *
+ * @brief Cloud or aerosol layer, from the derivative of ln(power)
+ *
+ * Altitudes in meters above the Lidar.
+ *
+ * @see Analyser::DetectLayers
+ */
+  struct Layer
+  {
+    /** @brief Altitude where ln(power) starts to increase */
+    Float_t fBase;
+    /** @brief Altitude of the maximum of ln(power), 0 if not reached */
+    Float_t fPeak;
+    /** @brief Altitude where ln(power) is back to a clear sky slope,
+     *  0 if the signal is lost inside the layer */
+    Float_t fTop;
+    /** @brief Increase of ln(power) from base to peak */
+    Float_t fStrength;
+  };
+
+/** @struct ShotClass
+ *
+ * @brief Outcome of the early classification of one channel
+ *
+ * @see Analyser::Classify
+ */
+  struct ShotClass
+  {
+    /** @brief Classifier decision */
+    enum Verdict {
+      kNotClassified=-1, ///< classifier not run
+      kAccept=0,         ///< processed, nothing to report
+      kFlag=1,           ///< processed, see the reasons
+      kReject=2          ///< not processed, see the reasons
+    };
+    /** @brief Classifier reasons, bits of fReasons */
+    enum Reason {
+      kNoQualityPeak=1<<0, ///< no sample of the trace below QualityThr
+      kNoBackground=1<<1,  ///< less than 2 samples in the background window
+      kLowSignal=1<<2,     ///< signal lost in the lowest coarse bin or below ClassifyMinSignalAlt
+      kClipped=1<<3,       ///< samples of the analysis window stuck at the ADC rail
+      kBkgDrift=1<<4,      ///< background drift above ClassifyBkgDriftMax
+      kBkgNoisy=1<<5,      ///< background RMS above ClassifyBkgRMSMax
+      kCloud=1<<6          ///< layer found by DetectLayers or coarse ln(power) rising
+    };
+    /** @brief Reset the classification */
+    void Reset() {
+      fVerdict=kNotClassified; fReasons=0;
+      fBkgDrift=0; fSNR=0; fSignalLostAltitude=0; fCloudAltitude=0;
+      }
+    /** @brief Return the reasons as a comma separated list of names
+     *
+     * @param reasons bits of Reason
+     */
+    static std::string GetReasonString(UInt_t reasons);
+    /** @brief Verdict */
+    Int_t   fVerdict;
+    /** @brief Reasons, bits of Reason */
+    UInt_t  fReasons;
+    /** @brief Background drift over the background window, in % of the background */
+    Float_t fBkgDrift;
+    /** @brief S/N per sample of the lowest coarse bin */
+    Float_t fSNR;
+    /** @brief Altitude above the Lidar of the first coarse bin below ClassifyMinSNR,
+     *  top of the analysis window if the signal is seen up to there */
+    Float_t fSignalLostAltitude;
+    /** @brief Base altitude above the Lidar of the lowest layer, 0 if none */
+    Float_t fCloudAltitude;
+  };
+
+/** @struct EnsembleStats
+ *
+ * @brief Spread of the optical depths over the Monte Carlo replicas of one channel
+ *
+ * Percentiles 16, 50 and 84 bracket the central 68% of the replicas.
+ *
+ * @see Analyser::RunEnsemble
+ */
+  struct EnsembleStats
+  {
+    /** @brief Reset all statistics */
+    void Reset() {
+      fNReplicas=0; fNFailed=0;
+      fOD=0; fODRMS=0; fOD16=0; fOD50=0; fOD84=0;
+      fAOD=0; fAODRMS=0; fAOD16=0; fAOD50=0; fAOD84=0;
+      }
+    /** @brief Number of replicas drawn */
+    Int_t   fNReplicas;
+    /** @brief Replicas with less than 2 bins below R0 or a failed inversion */
+    Int_t   fNFailed;
+    /** @brief Mean total OD */
+    Float_t fOD;
+    /** @brief RMS of the total OD */
+    Float_t fODRMS;
+    /** @brief 16th percentile of the total OD */
+    Float_t fOD16;
+    /** @brief Median of the total OD */
+    Float_t fOD50;
+    /** @brief 84th percentile of the total OD */
+    Float_t fOD84;
+    /** @brief Mean AOD, 0 if the algorithm has no particle profile */
+    Float_t fAOD;
+    /** @brief RMS of the AOD */
+    Float_t fAODRMS;
+    /** @brief 16th percentile of the AOD */
+    Float_t fAOD16;
+    /** @brief Median of the AOD */
+    Float_t fAOD50;
+    /** @brief 84th percentile of the AOD */
+    Float_t fAOD84;
+  };
+
+/** @struct SensitivityStats
+ *
+ * @brief Optical depths of one channel and their derivatives with respect
+ *  to the inversion parameters, indexed by SensitivityParam
+ *
+ * @see Analyser::ComputeSensitivities
+ */
+  struct SensitivityStats
+  {
+    /** @brief Reset all values */
+    void Reset() {
+      fDone=false; fOD=0; fAOD=0;
+      for(Int_t k=0; k<kNSensitivities; k++){fdOD[k]=0; fdAOD[k]=0;}
+      }
+    /** @brief True once the derivatives are computed */
+    Bool_t  fDone;
+    /** @brief Total OD */
+    Float_t fOD;
+    /** @brief AOD, 0 if the algorithm has no particle profile */
+    Float_t fAOD;
+    /** @brief Derivatives of the total OD */
+    Float_t fdOD[kNSensitivities];
+    /** @brief Derivatives of the AOD */
+    Float_t fdAOD[kNSensitivities];
+  };
+
+/** @struct SpSolveStats
+ *
+ * @brief Particle lidar ratio retrieved from an external AOD for one channel
+ *
+ * @see Analyser::SolveSp
+ */
+  struct SpSolveStats
+  {
+    /** @brief Reset all values */
+    void Reset() {
+      fDone=false; fTargetAOD=0; fSp=0; fAOD=0; fNIter=0; fInvertRc=0;
+      }
+    /** @brief True once Sp is found and set */
+    Bool_t  fDone;
+    /** @brief External AOD, at the channel wavelength */
+    Float_t fTargetAOD;
+    /** @brief Lidar ratio, the last estimate if not converged */
+    Float_t fSp;
+    /** @brief AOD of the inversion for fSp */
+    Float_t fAOD;
+    /** @brief Number of iterations of the root finder */
+    Int_t   fNIter;
+    /** @brief Return code of the inversion that stopped the solve, 0 if none */
+    Int_t   fInvertRc;
+  };
+
+/** @struct ChannelResults
+ *
+ * @brief Per channel scalar results
+ */
+  struct ChannelResults
+  {
+    /** @brief Reset all results */
+    void Reset() {
+      ResetInversion();
+      fQuality=false; fBkg=0;
+      fPreScan.Reset();
+      fClass.Reset();
+      fLayersDone=false; fLayers.clear(); fLayerMaxAltitude=0;
+      }
+    /** @brief Reset the results of the inversion, keep the pre-scan and layers */
+    void ResetInversion() {
+      fHasDetails=false; fAlpha0=0;
+      fOD=0; fOD_M=0; fOD_P=0; fODModel=0; fODModel_P=0; fODErr=0;
+      fNIter=0; fConverged=true;
+      fEnsemble.Reset();
+      fSensitivity.Reset();
+      fSpSolve.Reset();
+      }
+    /** @brief Data quality flag */
+    Bool_t  fQuality;
+    /** @brief True if molecules and particles profiles are available */
+    Bool_t  fHasDetails;
+    /** @brief Background */
+    Float_t fBkg;
+    /** @brief Extinction at R0 */
+    Float_t fAlpha0;
+    /** @brief Total OD */
+    Float_t fOD;
+    /** @brief OD for Rayleigh scattering */
+    Float_t fOD_M;
+    /** @brief OD for Mie scattering */
+    Float_t fOD_P;
+    /** @brief OD for Model */
+    Float_t fODModel;
+    /** @brief OD for Model - Mie scattering */
+    Float_t fODModel_P;
+    /** @brief First order error of the OD, also of the AOD */
+    Float_t fODErr;
+    /** @brief Iterations of an iterative inversion, 0 otherwise */
+    Int_t   fNIter;
+    /** @brief False if an iterative inversion stopped at its maximal number
+     *  of iterations, the results are those of the last iteration */
+    Bool_t  fConverged;
+    /** @brief Raw signal statistics */
+    PreScanStats fPreScan;
+    /** @brief Early classification */
+    ShotClass fClass;
+    /** @brief True once layers have been searched for this shot */
+    Bool_t  fLayersDone;
+    /** @brief Layers, from bottom to top */
+    std::vector<Layer> fLayers;
+    /** @brief Highest altitude with enough signal to find layers */
+    Float_t fLayerMaxAltitude;
+    /** @brief Monte Carlo ensemble */
+    EnsembleStats fEnsemble;
+    /** @brief Derivatives of the optical depths */
+    SensitivityStats fSensitivity;
+    /** @brief Lidar ratio from an external AOD */
+    SpSolveStats fSpSolve;
+  };
+
+  class ThreadPool;
+  class AODTable;
 	
 /** @class Analyser
  * 
@@ -44,6 +347,16 @@ namespace LidarTools {
   {
   
   public:
+
+    /** @brief What is kept in memory once a shot is processed
+     *
+     * @see SetRetention
+     */
+    enum Retention {
+      kRetainAll=0,      ///< all products, including raw and intermediate signals
+      kRetainProducts=1, ///< profiles (alpha, beta, opacity, transmission) and scalars
+      kRetainScalars=2   ///< scalar results only (OD, AOD, quality, parameters)
+    };
      
     /** @brief class constructor.
      *
@@ -54,7 +367,23 @@ namespace LidarTools {
      * @param signalmap a map of Lidar data <wavelength, signal>
      * @param verbose a bool for verbosity
      */
-    Analyser(TArrayF, std::map<Int_t, TArrayF>, Bool_t verbose=false);
+    Analyser(const TArrayF&, const std::map<Int_t, TArrayF>&, Bool_t verbose=false);
+
+    /** @brief class constructor from a shared shot, raw data are not copied
+     *
+     * @param shot the raw data of a LidarFile or LidarFileSet
+     * @param verbose a bool for verbosity
+     */
+    Analyser(std::shared_ptr<const LidarShot>, Bool_t verbose=false);
+
+    /** @brief class constructor without data.
+     *
+     * Data are passed later on with Load, so that the same Analyser,
+     * and its calibration objects, can be reused for many shots.
+     *
+     * @param verbose a bool for verbosity
+     */
+    Analyser(Bool_t verbose=false);
    
     /** @brief class destructor
      * 
@@ -63,6 +392,80 @@ namespace LidarTools {
      */
     virtual ~Analyser(); 
    
+    /** @brief Load a new shot
+     *
+     * Reset all per-run results, restore the nominal configuration
+     * (R0 and AC may have been changed by the optimization of the previous
+     * shot) and re-initialize indices. The ConfigHandler, AtmoProfile,
+     * AtmoAbsorption and Overlap objects are kept, as well as the buffers
+     * of the result arrays.
+     *
+     * @param range a TArrayF of altitudes
+     * @param signalmap a map of Lidar data <wavelength, signal>
+     * @param run the run number
+     * @param seq the sequence number
+     * @param time the time stamp as a time_t
+     */
+    int Load(const TArrayF&, const std::map<Int_t, TArrayF>&,
+             Int_t run=-99999, Int_t seq=1, time_t time=0);
+
+    /** @brief Load a new shot, signal arrays are taken over without copy
+     *
+     * @param range a TArrayF of altitudes
+     * @param signalmap a map of Lidar data <wavelength, signal>, left empty
+     * @param run the run number
+     * @param seq the sequence number
+     * @param time the time stamp as a time_t
+     */
+    int Load(const TArrayF&, std::map<Int_t, TArrayF>&&,
+             Int_t run=-99999, Int_t seq=1, time_t time=0);
+
+    /** @brief Load a new shot shared read-only, raw data are not copied
+     *
+     * The Analyser keeps a reference to the shot until the next Load,
+     * so that the views returned by GetRawSignal stay valid.
+     *
+     * @param shot the raw data, e.g. from LidarFile::GetShot
+     * @param run the run number
+     * @param seq the sequence number
+     * @param time the time stamp as a time_t
+     */
+    int Load(std::shared_ptr<const LidarShot> shot,
+             Int_t run=-99999, Int_t seq=1, time_t time=0);
+
+    /** @brief Get the raw data of the current shot
+     * @return std::shared_ptr<const LidarShot>
+     */
+    std::shared_ptr<const LidarShot> GetShot() const {return fShot;}
+
+    /** @brief Get the peak scratch memory used since the last Load
+     * @return the number of bytes
+     */
+    Long64_t GetScratchPeakBytes() const {return fArena.GetPeakBytes();}
+
+    /** @brief Set what is kept in memory once a shot is processed
+     *
+     * With kRetainProducts and kRetainScalars, the background, reduced
+     * signal and power arrays are freed as soon as they are binned, the
+     * binned power once inverted, and the raw shot at the end of
+     * ProcessData. kRetainScalars also frees all profiles and altitude
+     * arrays. Freed products are empty in the getters and the Plotter.
+     * Buffers are allocated again by the next Load.
+     *
+     * @param retention the retention level, default kRetainAll
+     */
+    void SetRetention(Retention retention) {fRetention=retention;}
+
+    /** @brief Get the retention level */
+    Retention GetRetention() const       {return fRetention;}
+
+    /** @brief Get the memory held by the Analyser arrays
+     *
+     * Raw data shared with a LidarFile are included while they are held.
+     * @return the number of bytes
+     */
+    Long64_t GetMemoryHeld() const;
+
     /** @brief Get indices, and initialize variables
      *
      */
@@ -85,17 +488,31 @@ namespace LidarTools {
      */
     int SetConfig(char[]);
 
-    /** @brief Write configuration to members
+    /** @brief Pass a configuration
+     *
+     * The preparation of the current shot is kept if the configuration
+     * only changes parameters of the inversion.
+     *
+     *  @param config the configuration, copied
+     */
+    int SetConfig(const ConfigHandler&);
+
+    /** @brief Write configuration to members, from the compiled one
      *
      */
     int StoreConfigLocally();
 
     /** @brief Update ConfigHandler config from members
      *
+     * Only the per channel parameters, R0, Sp and the alignment correction,
+     * change while processing a shot.
      */
     int StoreConfigToHandler();
 
     /** @brief Overwrite a configuration parameter on the fly
+     *
+     * The overrides are kept apart from the nominal configuration and
+     * applied after the epochs of each run, they are cleared by SetConfig.
      *
      * @param key key string
      * @param value key value
@@ -123,39 +540,74 @@ namespace LidarTools {
 
     /** @brief Check data quality for the given wavelength
      *
-     *  Look for -5 V spike in raw signal 
+     *  Look for -5 V spike in raw signal, runs PreScan if not done yet
      *
      * @param wl the wavelength as an integer 
      * 
      */
     Bool_t CheckQuality(Int_t);
 
-    /** @brief Get the Signal to Noise Ratio at R0 for the given wavelength
+    /** @brief Fused pre-scan of the raw signal for the given wavelength
      *
-     *  If SNR is too low, consider a lower R0
+     * A single sweep over the raw trace computes the quality minimum,
+     * the background sum, sum of squares, count and slope, the number of
+     * saturated samples, subtracts the background and computes the
+     * signal power "P=V*R**2", corrected for the overlap function, in the
+     * analysis window. The reduced signal and background samples are
+     * only stored with kRetainAll. A last pass over the analysis window
+     * counts the clipped samples, runs of ClassifyClipRun samples or more
+     * at the trace minimum.
      *
-     * @param wl the wavelength as an integer
-     * @todo not implemented ! 
-     * 
+     * @param wl the wavelength as an integer 
+     * @see PreScanStats
      */
-    //Float_t VerifySNRatio(Int_t);
-
+    int PreScan(Int_t);
 
-    /** @brief Subtract background for the given wavelength
+    /** @brief Find cloud and aerosol layers for the given wavelength
+     *
+     * The derivative of ln(power) is computed with Savitzky-Golay
+     * coefficients over 2*LayerHalfWidth+1 samples, in a single pass over
+     * the analysis window. A layer base is where the derivative goes
+     * above LayerThreshold (per km), the peak where it gets back to 0,
+     * the top where it is back above -LayerThreshold after the decrease.
+     * The scan stops where the mean S/N in the window drops below
+     * LayerMinSNR, layers weaker than LayerMinStrength are ignored.
+     * Runs PreScan if not done yet.
      *
      * @param wl the wavelength as an integer 
-     * 
+     * @see Layer GetLayers
      */
-    void SubtractBackground(Int_t);
+    int DetectLayers(Int_t);
 
-    /** @brief Compute the signal power "P=V*R**2" for the given wavelength
-     *  Also compute Ln(Power) for plotting
+    /** @brief Early classification of the given wavelength, accept, flag or reject
+     *
+     * Runs on the pre-scan statistics, the layers and a coarse profile
+     * of ClassifyNCoarse bins of the analysis window, so that bad shots
+     * are rejected before any rebinning, optimization or inversion.
+     * The profile goes up in S/N per sample and ln(power) until the S/N
+     * drops below ClassifyMinSNR: the signal is low if it is lost in the
+     * lowest bin or below ClassifyMinSignalAlt, and a rise of ln(power)
+     * by LayerMinStrength from one bin to the next is a cloud, as the
+     * layers. Reasons in ClassifyRejectMask reject the shot, the other
+     * ones only flag it. Runs PreScan and DetectLayers if not done yet.
      *
      * @param wl the wavelength as an integer 
+     * @return the ShotClass verdict
+     * @see ShotClass
+     */
+    Int_t Classify(Int_t);
+
+    /** @brief Get the Signal to Noise Ratio at R0 for the given wavelength
+     *
+     *  If SNR is too low, consider a lower R0
+     *
+     * @param wl the wavelength as an integer
+     * @todo not implemented ! 
      * 
      */
-    void ComputePower(Int_t);
-    
+    //Float_t VerifySNRatio(Int_t);
+
+
     /** @brief Filter the signal power for the given wavelength
      * 
      * The SavGolFilter class that implements a Savitsky-Golay filtering is
@@ -168,8 +620,8 @@ namespace LidarTools {
      */
     void FilterPower(Int_t);
 
-    /** @brief Rebin data proxy, calls either RebinDataLog or
-     *  RebinDataLinear
+    /** @brief Rebin data proxy, calls either RebinDataAdaptive,
+     *  RebinDataLog or RebinDataGAF
      *
      * @param wl the wavelength as an integer 
      * 
@@ -177,6 +629,8 @@ namespace LidarTools {
     void RebinData(Int_t);    
 
     /** @brief Rebin data in logarithmic bins of altitude for the given wavelength
+     *
+     *  Mean and standard deviation of each bin from the prefix sums of the power
      *
      * @param wl the wavelength as an integer 
      * 
@@ -186,11 +640,41 @@ namespace LidarTools {
     /** @brief Rebin data linearly in altitude for the given wavelength
      *  using a gliding average filter
      * 
+     *  Windows are two bins wide and move by one bin, as in GlidingAveFilter,
+     *  their mean and standard deviation come from the prefix sums of the power.
+     *  Bin edges are half way between the window centers.
+     * 
      * @param wl the wavelength as an integer      
      * 
      */
     void RebinDataGAF(Int_t);
 
+    /** @brief Rebin data so that the mean power of each bin reaches
+     *  a target S/N
+     *
+     *  Bins are at least (AltMax-AltMin)/NBins wide and grow with altitude
+     *  until mean/sqrt(var/m) >= AdaptiveBinsSNR, m being the number of samples.
+     *  The noise variance var is estimated from the differences of successive
+     *  raw samples, so that the slope of the profile does not count as noise.
+     *  Prefix sums of the power and of the squared differences give each bin
+     *  in O(1), so that the whole binning is a single O(N) sweep.
+     *  The samples left above the last complete bin make a last bin, below
+     *  the target S/N, or are merged into the previous bin if there is a single one.
+     *  Bins with a negative mean power are never closed.
+     *
+     *  The bins are shared by all channels: they are built from the S/N of
+     *  the first channel binned in the shot, the other channels are binned
+     *  on the same edges.
+     *
+     *  The binned power deviation is the noise standard deviation sqrt(var),
+     *  as for the other binnings, the standard error of the mean is this
+     *  deviation over sqrt(m).
+     *
+     * @param wl the wavelength as an integer 
+     * 
+     */
+    void RebinDataAdaptive(Int_t);
+
     /** @brief Rebin data linearly in altitude for the given wavelength
      *
      * @param wl the wavelength as an integer 
@@ -198,6 +682,154 @@ namespace LidarTools {
      */
     void RebinDataLinear(Int_t);
 
+    /** @brief Rebin the power of the given wavelength in any bins
+     *
+     *  The mean and standard deviation of each bin come from the prefix
+     *  sums of the power kept by the last rebinning of this wavelength,
+     *  in O(number of bins), the current binning is not modified.
+     *  Bin k holds the samples with edges[k] <= altitude < edges[k+1],
+     *  a bin narrower than a sample takes the next sample.
+     *  This makes scans over the binning cheap, e.g. after ProcessData.
+     *  The prefix sums are freed with the power by the retention levels.
+     *
+     * @param wl the wavelength as an integer 
+     * @param edges the bins edges, in m above the Lidar, increasing
+     * @param mean the mean power of each bin, resized
+     * @param stddev the standard deviation of the power in each bin, resized
+     * @return 0 if OK, 1 if there are no prefix sums for this wavelength
+     */
+    int RebinPower(Int_t wl, const TArrayF& edges, TArrayF& mean, TArrayF& stddev) const;
+
+    /** @brief run the inversion algorithm chosen by AlgName for the given wavelength
+     *
+     * the algorithm is resolved once per configuration by the InversionRegistry
+     *
+     * @param wl the wavelength as an integer
+     * @return 0 if OK, 1 if less than 2 bins below R0, 2 if the algorithm is unknown
+     */
+    int Invert(Int_t wl);
+
+    /** @brief run an inversion algorithm for the given wavelength
+     *
+     * fills extinction and backscatter, with the molecular and particle
+     * splits if the algorithm has details, and the model extinction.
+     * If PropagateErrors is set, the errors of the binned power are carried
+     * through the recurrence to first order, giving the errors of the
+     * extinction, backscatter and optical depth in the same pass.
+     * Algorithms that weight the power with its errors, as OptimalEstimation,
+     * always get them, but fill the errors of their outputs only if
+     * PropagateErrors is set.
+     *
+     * @param wl the wavelength as an integer
+     * @param inversion the algorithm
+     * @return 0 if OK, 1 if less than 2 bins below R0
+     */
+    int Invert(Int_t wl, const Inversion& inversion);
+
+    /** @brief run the inversion chosen by AlgName for two wavelengths at once
+     *
+     * The slabs and the molecular extinction are computed once, at wl1, up
+     * to the highest of the two references, the molecular extinction at
+     * wl2 is the one at wl1 scaled with the Rayleigh wavelength dependence,
+     * see AtmoProfile::ExtinctionScale. Both channels are then inverted as
+     * by Invert, and if the algorithm has details, the Angstrom exponent
+     * and the colour ratio profiles of the pair are filled in one sweep.
+     * The bins are shared by all channels, the profiles stop at the lowest
+     * of the two references.
+     *
+     * Called by ProcessData for JointWl1 and JointWl2 when JointInversion is set.
+     *
+     * @see GetAngstromExpProfile GetColourRatioProfile
+     * @param wl1 the first wavelength as an integer
+     * @param wl2 the second wavelength as an integer
+     * @return 0 if OK, 1 if there is no binned power or less than 2 bins below R0,
+     *         2 if the algorithm is unknown
+     */
+    int InvertJoint(Int_t wl1, Int_t wl2);
+
+    /** @brief run the Fernald inversion for many lidar ratios and
+     *  correction factors at once, in a batch
+     *
+     * only the optical depths in the [TauAltMin, TauAltMax] window
+     * are kept, the analyser results are not changed
+     *
+     * @param wl the wavelength as an integer
+     * @param lanes the number of inversions
+     * @param Sp the particle lidar ratio of each inversion
+     * @param alignCorr the mis-alignment correction factor of each inversion
+     * @param od the total optical depth of each inversion
+     * @param aod the particle optical depth of each inversion
+     * @return 0 if OK, 1 if less than 2 bins below R0 or unknown wavelength
+     */
+    int Fernald84Scan(Int_t wl, Int_t lanes, const Float_t* Sp,
+                      const Float_t* alignCorr, Float_t* od, Float_t* aod);
+
+    /** @brief run the Monte Carlo ensemble of the inversion for the given wavelength
+     *
+     * Each replica draws the binned power from its error, the standard
+     * deviation of the bin over the square root of its number of samples,
+     * and Sp, sratio, R0 and the background fudge factor from Gaussian priors
+     * around their current values (EnsembleSpSigma, EnsembleSratioSigma,
+     * EnsembleR0Sigma, EnsembleBkgFFactorSigma). A change of background is
+     * propagated to the binned power to first order, the signal is not
+     * scanned again. The replicas run the configured inversion on
+     * EnsembleThreads threads, replica i uses the random stream i of
+     * EnsembleSeed, run, sequence and wavelength, so that results do not
+     * depend on the number of threads.
+     *
+     * Called by ProcessData when EnsembleSize>0, needs the binned power.
+     *
+     * @see GetEnsembleStats GetEnsembleAlphaProfile
+     * @param wl the wavelength as an integer
+     * @return 0 if OK, 1 if there is no binned power or no valid replica
+     */
+    int RunEnsemble(Int_t wl);
+
+    /** @brief derivatives of the optical depths with respect to Sp, sratio,
+     *  R0, AlignCorr and BkgFFactor for the given wavelength
+     *
+     * The configured inversion runs once on dual numbers, from the binned
+     * power and its derivatives: a change of background fudge factor is
+     * propagated to the binned power to first order, as in RunEnsemble.
+     * R0 is taken as continuous, the reference moves within its bin with
+     * the local slopes of the binned power and of the extinction profiles,
+     * and the top slab stretches. dOD/dR0 is then a continuous estimate of
+     * the effect of the discrete steps of R0, below TauAltMax it includes
+     * the extinction at the reference, where the optical depths stop.
+     *
+     * Called by ProcessData when Sensitivities is set, needs the binned power.
+     *
+     * @see GetSensitivities
+     * @param wl the wavelength as an integer
+     * @return 0 if OK, 1 if there is no binned power or less than 2 bins below R0,
+     *         3 if the algorithm is not differentiable
+     */
+    int ComputeSensitivities(Int_t wl);
+
+    /** @brief find the particle lidar ratio Sp for which the AOD of the
+     *  inversion is the target AOD, for the given wavelength
+     *
+     * Brent root finder on Sp between SpSolveMin and SpSolveMax, down to
+     * SpSolveTolerance in sr and within SpSolveMaxIter iterations. The
+     * geometry, binned power and profiles are prepared once, each iteration
+     * runs the configured inversion and integrates the AOD from TauAltMin
+     * to TauAltMax only. On success Sp is set for the channel, as
+     * SetParamFSp would, otherwise it is not changed.
+     *
+     * Called by ProcessData when SpSolve is set, before the inversion,
+     * with the AOD of the run in the AODTable file, needs the binned power.
+     *
+     * @see GetSpSolveStats
+     * @param wl the wavelength as an integer
+     * @param targetAOD the AOD to reach at wl
+     * @return 0 if OK, 1 if there is no binned power or less than 2 bins below R0,
+     *         2 if the target is not between the AODs of SpSolveMin and SpSolveMax
+     *         or not reached within SpSolveMaxIter iterations,
+     *         3 if the algorithm has no particle profile,
+     *         4 if an inversion failed, its return code is in GetSpSolveStats
+     */
+    int SolveSp(Int_t wl, Float_t targetAOD);
+
     /** @brief run the Klett inversion algorithm for the given wavelength
      *
      * uses parameters as initialized by the ConfigHandler
@@ -230,16 +862,20 @@ namespace LidarTools {
      */
     void AeronetInversion(Int_t);    
 
-    /** @brief Compute atmosphere opacity profile
+    /** @brief Compute atmosphere opacity and transmission profiles
      *
      * and Optical depths for atmosphere opacity from TauMin to TauMax
-     * integral of alpha
+     * integral of alpha, for total, molecules, particles and model,
+     * in one pass with IntegrateOpacity. Called by the inversions.
      *
      * @param wl the wavelength as an integer 
      */
     void ComputeAtmosphereOpacity(Int_t);
 
     /** @brief Compute atmosphere transmission profile
+     *
+     * transmission is already computed by ComputeAtmosphereOpacity,
+     * this recomputes it from the opacity profiles
      *
      * @param wl the wavelength as an integer 
      */
@@ -267,7 +903,7 @@ namespace LidarTools {
      *
      * @param time the time stamp as a time_t
      */
-    void SetTime(time_t time) {fTimeStamp=time;};
+    void SetTime(time_t time);
 
     // Getters
 
@@ -277,42 +913,58 @@ namespace LidarTools {
     * @return Float_t
     */
     Float_t GetParamR0(Int_t wl) const          {
-		if (wl==355)        return fParamR0_355;
-		else if (wl==532)  return fParamR0_532;
+		Int_t slot=fChannels.GetSlot(wl);
+		if (slot>=0)       return fParams[slot].fR0;
 		else               return 0;
 		 }
 
    /** @brief Sets the calibration altitude for the inversion in the current configuration
     *  for a given wave length
     *  
-    * @return Float_t
+    * @return 0 if ok, 1 for an unknown wave length
     */
-    void SetParamR0(Int_t wl, float r0)           {
-		if (wl==355)         fParamR0_355=r0;
-		else if (wl==532)   fParamR0_532=r0;
-		else exit(1);
+    int SetParamR0(Int_t wl, float r0)           {
+		Int_t slot=fChannels.GetSlot(wl);
+		if (slot<0) return 1;
+		fParams[slot].fR0=r0;
+		return 0;
 		 }
 
+   /** @brief Returns the first wavelength of the joint inversion in the current configuration
+    * @see InvertJoint
+    *  
+    * @return Int_t
+    */
+    Int_t GetParamJointWl1() const          {return fParamJointWl1;}
+
+   /** @brief Returns the second wavelength of the joint inversion in the current configuration
+    * @see InvertJoint
+    *  
+    * @return Int_t
+    */
+    Int_t GetParamJointWl2() const          {return fParamJointWl2;}
+
    /** @brief Returns the Fernald_Sp for the inversion in the current configuration
     *  for a given wave length
     *  
     * @return Float_t
     */
     Float_t GetParamFSp(Int_t wl) const          {
-		if (wl==355)        return fFernald84_Sp355;
-		else if (wl==532)  return fFernald84_Sp532;
+		Int_t slot=fChannels.GetSlot(wl);
+		if (slot>=0)       return fParams[slot].fSp;
 		else               return 50;
 		 }
 
    /** @brief Sets the Fernald_Sp for the inversion in the current configuration
     *  for a given wave length
     *  
-    * @return void
+    * @return 0 if ok, 1 for an unknown wave length
     */
-    void SetParamFSp(Int_t wl, Float_t Sp)          {
-		if (wl==355)        fFernald84_Sp355=Sp;
-		else if (wl==532)  fFernald84_Sp532=Sp;
-		else exit(1);
+    int SetParamFSp(Int_t wl, Float_t Sp)          {
+		Int_t slot=fChannels.GetSlot(wl);
+		if (slot<0) return 1;
+		fParams[slot].fSp=Sp;
+		return 0;
 		 }
 
    /** @brief Returns the Mis-Alignment correction factor in the current configuration
@@ -321,20 +973,21 @@ namespace LidarTools {
     * @return Float_t
     */
     Float_t GetParamFAC(Int_t wl) const          {
-		if (wl==355)        return fParamAlignCorr_355;
-		else if (wl==532)  return fParamAlignCorr_532;
-		else               return 50;
+		Int_t slot=fChannels.GetSlot(wl);
+		if (slot>=0)       return fParams[slot].fAlignCorr;
+		else               return 0;
 		 }
 
    /** @brief Sets the Mis-Alignement corection factor in the current configuration
     *  for a given wave length
     *  
-    * @return void
+    * @return 0 if ok, 1 for an unknown wave length
     */
-    void SetParamFAC(Int_t wl, Float_t ACcor)     {
-		if (wl==355)        fParamAlignCorr_355=ACcor;
-		else if (wl==532)  fParamAlignCorr_532=ACcor;
-		else exit(1);
+    int SetParamFAC(Int_t wl, Float_t ACcor)     {
+		Int_t slot=fChannels.GetSlot(wl);
+		if (slot<0) return 1;
+		fParams[slot].fAlignCorr=ACcor;
+		return 0;
 		 }
     
     /** @brief Get Run Number
@@ -347,8 +1000,9 @@ namespace LidarTools {
 
     /** @brief Get Time String
      *
+     * The string is formatted once in SetTime, no static buffer is involved.
      */
-    char* GetTimeString()                    {return ctime(&fTimeStamp);}
+    const char* GetTimeString() const        {return fTimeString;}
 
     /** @brief Get Theta
      *
@@ -365,20 +1019,28 @@ namespace LidarTools {
      */
     Float_t GetLidarAltitude() const         {return fLidarAltitude;}
     
-    /** @brief Get the TArrayF of raw range
+    /** @brief Get the raw range
      *
      */
-    TArrayF GetRawRange() const             {return fRawRange;}
+    FloatView GetRawRange() const            {return fRawRange;}
 
-    /** @brief Get the TArrayF of altitudes
+    /** @brief Get the altitudes
      *
      */
-    TArrayF GetAltitudes() const             {return fAltitude;}
+    FloatView GetAltitudes() const           {return fAltitude;}
     
-    /** @brief Get a TArrayF of the center of the altitude bins
+    /** @brief Get the center of the altitude bins
      *  @see RebinData
      */
-    TArrayF GetBinsCenterAltitude() const    {return fBinsCenterAltitude;}
+    FloatView GetBinsCenterAltitude() const  {return fBinsCenterAltitude;}
+
+    /** @brief Get the number of bins of the current binning
+     *
+     *  Equal to NBins for logarithmic and linear bins, to the number of
+     *  samples for the gliding average and depends on the S/N for adaptive bins.
+     *  @see RebinData
+     */
+    UInt_t GetNBins() const                  {return fNBins;}
 
     /** @brief Get Bkg Min range
      */
@@ -394,100 +1056,235 @@ namespace LidarTools {
      * 
      * @param wl the wavelength as an integer 
     */
-    const Bool_t  GetQuality(Int_t wl)       {return fQualityMap[wl];}    
+    Bool_t GetQuality(Int_t wl) const        {
+		Int_t slot=fChannels.GetSlot(wl);
+		return slot>=0 ? fResults[slot].fQuality : false;
+		}
 
-    /** @brief Get the TArrayF of raw signal for the given wavelength
+    /** @brief Get the raw signal for the given wavelength
      *
      * @param wl the wavelength as an integer 
     */
-    const TArrayF GetRawSignal(Int_t wl)     {return fSignalMap[wl];}
+    FloatView GetRawSignal(Int_t wl) const   {
+		Int_t slot=fChannels.GetSlot(wl);
+		return slot>=0 ? fRawSignal[slot] : FloatView();
+		}
 
     /** @brief Get the background value for a given wavelength
      *
-     * @see SubtractBackground
+     * @see PreScan
+     * @param wl the wavelength as an integer 
+    */
+    Float_t GetBkg(Int_t wl) const           {
+		Int_t slot=fChannels.GetSlot(wl);
+		return slot>=0 ? fResults[slot].fBkg : 0;
+		}
+
+    /** @brief Get the raw data used to estimate the background
+     *
+     * @see PreScan
+     * @param wl the wavelength as an integer 
+    */
+    FloatView GetFullBkg(Int_t wl) const     {return fFullBkg.View(fChannels.GetSlot(wl));}
+
+    /** @brief Get the raw signal statistics for a given wavelength
+     *
+     * @see PreScan
      * @param wl the wavelength as an integer 
     */
-    const TArrayF GetBkg(Int_t wl)           {return fBkgMap[wl];}
+    const PreScanStats& GetPreScanStats(Int_t wl) const;
 
-    /** @brief Get a TArrayF of the raw data used to estimate the background
+    /** @brief Get the early classification for a given wavelength
      *
-     * @see SubtractBackground
+     * @see Classify
      * @param wl the wavelength as an integer 
     */
-    const TArrayF GetFullBkg(Int_t wl)       {return fFullBkgMap[wl];}
+    const ShotClass& GetShotClass(Int_t wl) const;
 
-    /** @brief Get a TArrayF of reduced signal for a given wavelength
+    /** @brief Get the first order error of the optical depth, from the
+     *  binned power errors, 0 unless PropagateErrors is set. Molecules
+     *  have no error, so that it is also the error of the AOD.
      *
-     * @see SubtractBackground 
+     * @see Invert
      * @param wl the wavelength as an integer 
     */
-    const TArrayF GetReducedSignal(Int_t wl) {return fReducedSignalMap[wl];}
+    Float_t GetODErr(Int_t wl) const;
 
-    /** @brief Get a TArrayF of the signal power
+    /** @brief Get the number of iterations of an iterative inversion,
+     *  as OptimalEstimation, 0 for the other ones
      *
-     * @see ComputePower
+     * @see Invert IsConverged
      * @param wl the wavelength as an integer 
     */
-    const TArrayF GetPower(Int_t wl)         {return fPowMap[wl];}
+    Int_t GetNIter(Int_t wl) const;
 
-    /** @brief Get a TArrayF of the filtered signal power
+    /** @brief Return false if an iterative inversion stopped at its maximal
+     *  number of iterations, OEMaxIter, the results are then those of the
+     *  last iteration and the channel is processed with a warning
+     *
+     * @see Invert GetNIter
+     * @param wl the wavelength as an integer 
+    */
+    Bool_t IsConverged(Int_t wl) const;
+
+    /** @brief Get the optical depths spread of the Monte Carlo ensemble
+     *
+     * @see RunEnsemble
+     * @param wl the wavelength as an integer 
+    */
+    const EnsembleStats& GetEnsembleStats(Int_t wl) const;
+
+    /** @brief Get the optical depths and their derivatives
+     *
+     * @see ComputeSensitivities
+     * @param wl the wavelength as an integer 
+    */
+    const SensitivityStats& GetSensitivities(Int_t wl) const;
+
+    /** @brief Get the lidar ratio retrieved from an external AOD
+     *
+     * @see SolveSp
+     * @param wl the wavelength as an integer 
+    */
+    const SpSolveStats& GetSpSolveStats(Int_t wl) const;
+
+    /** @brief Get the Angstrom exponent profile of a joint inversion
+     *
+     *  Angstrom Exponent = -log(od_p_wl1/od_p_wl2)/log(wl1/wl2), from the
+     *  particle opacity profiles, NaN in the bins where one of them is not
+     *  positive. Empty if the last joint inversion was not for wl1 and wl2,
+     *  or had no particle profiles.
+     *
+     * @see InvertJoint
+     * @param wl1 the first wavelength as an integer 
+     * @param wl2 the second wavelength as an integer 
+    */
+    FloatView GetAngstromExpProfile(Int_t wl1, Int_t wl2) const;
+
+    /** @brief Get the colour ratio profile of a joint inversion
+     *
+     *  Colour Ratio = beta_p_wl2/beta_p_wl1, NaN in the bins where beta_p_wl1
+     *  is zero, empty as GetAngstromExpProfile
+     *
+     * @see InvertJoint
+     * @param wl1 the first wavelength as an integer 
+     * @param wl2 the second wavelength as an integer 
+    */
+    FloatView GetColourRatioProfile(Int_t wl1, Int_t wl2) const;
+
+    /** @brief Get the layers found for a given wavelength, from bottom to top
+     *
+     * @see DetectLayers
+     * @param wl the wavelength as an integer 
+    */
+    const std::vector<Layer>& GetLayers(Int_t wl) const;
+
+    /** @brief Return true if at least one wavelength was rejected
+     *
+     * @see Classify
+    */
+    Bool_t IsRejected() const;
+
+    /** @brief Get the reduced signal for a given wavelength
+     *
+     * @see PreScan
+     * @param wl the wavelength as an integer 
+    */
+    FloatView GetReducedSignal(Int_t wl) const {return fReducedSignal.View(fChannels.GetSlot(wl));}
+
+    /** @brief Get the signal power
+     *
+     * @see PreScan
+     * @param wl the wavelength as an integer 
+    */
+    FloatView GetPower(Int_t wl) const       {return fPow.View(fChannels.GetSlot(wl));}
+
+    /** @brief Get the filtered signal power
      *
      * @see FilterPower
      * @param wl the wavelength as an integer 
     */
-    const TArrayF GetFilteredPower(Int_t wl) {return fFilteredPowMap[wl];}
+    FloatView GetFilteredPower(Int_t wl) const {return fFilteredPow.View(fChannels.GetSlot(wl));}
  
-    /** @brief Get a TArrayF of the binned signal power
+    /** @brief Get the binned signal power
      *
-     * @see ComputePower RebinData
+     * @see PreScan RebinData
      * @param wl the wavelength as an integer 
     */
-    const TArrayF GetBinnedPower(Int_t wl)   {return fBinnedPowMap[wl];}
+    FloatView GetBinnedPower(Int_t wl) const {return fBinnedPow.View(fChannels.GetSlot(wl));}
 
-    /** @brief Get a TArrayF of the binned signal power standard deviation
+    /** @brief Get the binned signal power standard deviation
      *
-     * @see ComputePower RebinDataGAF
+     * @see PreScan RebinDataGAF
      * @param wl the wavelength as an integer 
     */
-    const TArrayF GetBinnedPowerDev(Int_t wl)   {return fBinnedPowDevMap[wl];}
+    FloatView GetBinnedPowerDev(Int_t wl) const {return fBinnedPowDev.View(fChannels.GetSlot(wl));}
 
-    /** @brief Get a TArrayF of the extinction profile
+    /** @brief Get the extinction profile
      *
      * @see KlettInversion, Fernald84Inversion
      * @param wl the wavelength as an integer 
      * @param scattering kind of profile (total "T", Moelcules "M", Mie "P")
     */
-    TArrayF GetAlphaProfile(Int_t wl, std::string scattering);
+    FloatView GetAlphaProfile(Int_t wl, std::string scattering) const {
+		return SelectProduct(fAlpha, fAlpha_M, fAlpha_P, scattering).View(fChannels.GetSlot(wl));
+		}
 
-   /** @brief Get a TArrayF of the total extinction profile
+   /** @brief Get the total extinction profile
      *
      * @see KlettInversion, Fernald84Inversion
      * @param wl the wavelength as an integer 
     */
-    TArrayF GetAlphaProfile(Int_t wl) {return GetAlphaProfile(wl, "T");}
+    FloatView GetAlphaProfile(Int_t wl) const {return GetAlphaProfile(wl, "T");}
+
+    /** @brief Get a percentile of the extinction over the Monte Carlo ensemble,
+     *  on the bins of the extinction profile
+     *
+     * @see RunEnsemble
+     * @param wl the wavelength as an integer 
+     * @param percentile 16, 50 or 84, an empty view otherwise
+    */
+    FloatView GetEnsembleAlphaProfile(Int_t wl, Int_t percentile) const;
 
-    /** @brief Get a TArrayF of the backscatter profile
+    /** @brief Get the first order error of the total extinction,
+     *  empty unless PropagateErrors is set
+     *
+     * @see Invert
+     * @param wl the wavelength as an integer 
+    */
+    FloatView GetAlphaErrProfile(Int_t wl) const {return fAlphaErr.View(fChannels.GetSlot(wl));}
+
+    /** @brief Get the backscatter profile
      *
      * @see KlettInversion, Fernald84Inversion
      * @param wl the wavelength as an integer 
      * @param scattering kind of profile (total "T", Molecules "M", Mie "P")
     */
-    TArrayF GetBetaProfile(Int_t wl, std::string scattering);
+    FloatView GetBetaProfile(Int_t wl, std::string scattering) const {
+		return SelectProduct(fBeta, fBeta_M, fBeta_P, scattering).View(fChannels.GetSlot(wl));
+		}
 
-    /** @brief Get a TArrayF of the total backscatter profile
+    /** @brief Get the total backscatter profile
      *
      * @see KlettInversion, Fernald84Inversion
      * @param wl the wavelength as an integer 
     */
-    TArrayF GetBetaProfile(Int_t wl) {return GetBetaProfile(wl,"T");}
+    FloatView GetBetaProfile(Int_t wl) const {return GetBetaProfile(wl,"T");}
+
+    /** @brief Get the first order error of the total backscatter,
+     *  empty unless PropagateErrors is set
+     *
+     * @see Invert
+     * @param wl the wavelength as an integer 
+    */
+    FloatView GetBetaErrProfile(Int_t wl) const {return fBetaErr.View(fChannels.GetSlot(wl));}
 
-   /** @brief Get a TArrayF of the atmosphere model total extinction profile
+   /** @brief Get the atmosphere model total extinction profile
      *
      * @see KlettInversion, Fernald84Inversion
      * @param wl the wavelength as an integer 
     */
-    TArrayF GetAlphaModelProfile(Int_t wl) {if(fAlphaModelMap.count(wl)>0) return fAlphaModelMap[wl];
-		                            else return false;}
+    FloatView GetAlphaModelProfile(Int_t wl) const {return fAlphaModel.View(fChannels.GetSlot(wl));}
 
     
     /** @brief Return true if detailed particle and molecule information
@@ -496,8 +1293,10 @@ namespace LidarTools {
      * @see Fernald84Inversion
      * @param wl the wavelength as an integer 
     */
-    bool hasDetails(Int_t wl)  {if(fAlphaMap_P.count(wl)>0) return true;
-		                        else return false;}
+    bool hasDetails(Int_t wl) const {
+		Int_t slot=fChannels.GetSlot(wl);
+		return slot>=0 ? fResults[slot].fHasDetails : false;
+		}
 
     /** @brief Return true if data were filtered
      *
@@ -513,56 +1312,69 @@ namespace LidarTools {
      * @param wl the wavelength as an integer 
      * @param scattering kind of profile (total "T", Molecules "M", Mie "P")
     */
-    TArrayF GetOpacityProfile(Int_t wl, std::string scattering);
+    FloatView GetOpacityProfile(Int_t wl, std::string scattering) const {
+		return SelectProduct(fOpacity, fOpacity_M, fOpacity_P, scattering).View(fChannels.GetSlot(wl));
+		}
 
     /** @brief Get the total opacity profile value for the given wavelength
      *
      * @see ComputeAtmosphereOpacity
      * @param wl the wavelength as an integer 
     */
-    TArrayF GetOpacityProfile(Int_t wl)          {return GetOpacityProfile(wl,"T");}
+    FloatView GetOpacityProfile(Int_t wl) const  {return GetOpacityProfile(wl,"T");}
 
     /** @brief Get the opacity model profile value for the given wavelength
      *
      * @see ComputeAtmosphereOpacity AtmoAbsorption
      * @param wl the wavelength as an integer 
     */
-    TArrayF GetOpacityModelProfile(Int_t wl)          {return fOpacityModelMap[wl];}
+    FloatView GetOpacityModelProfile(Int_t wl) const {return fOpacityModel.View(fChannels.GetSlot(wl));}
 
     /** @brief Get the transmission profile value for the given wavelength
      *
-     * @see ComputeAtmosphereTransmission
+     * @see ComputeAtmosphereOpacity
      * @param wl the wavelength as an integer 
+     * @param scattering kind of profile (total "T", Molecules "M", Mie "P")
     */
-    TArrayF GetTransmissionProfile(Int_t wl)          {return fTransmissionMap[wl];}
+    FloatView GetTransmissionProfile(Int_t wl, std::string scattering) const {
+		return SelectProduct(fTransmission, fTransmission_M, fTransmission_P, scattering).View(fChannels.GetSlot(wl));
+		}
+
+    /** @brief Get the total transmission profile value for the given wavelength
+     *
+     * @see ComputeAtmosphereOpacity
+     * @param wl the wavelength as an integer 
+    */
+    FloatView GetTransmissionProfile(Int_t wl) const {return GetTransmissionProfile(wl,"T");}
 
     /** @brief Get the Transmission model profile value for the given wavelength
      *
-     * @see ComputeAtmosphereTransmission AtmoAbsorption
+     * @see ComputeAtmosphereOpacity AtmoAbsorption
      * @param wl the wavelength as an integer 
     */
-    TArrayF GetTransmissionModelProfile(Int_t wl)          {return fTransmissionModelMap[wl];}
+    FloatView GetTransmissionModelProfile(Int_t wl) const {return fTransmissionModel.View(fChannels.GetSlot(wl));}
 
     /** @brief Get the integrated opacity value for the given wavelength
      *
      * @see ComputeAtmosphereOpacity KlettInversion
      * @param wl the wavelength as an integer 
+     * @param scattering kind of profile (total "T", Molecules "M", Mie "P")
     */
-    Float_t GetOD(Int_t wl, std::string scattering);
+    Float_t GetOD(Int_t wl, std::string scattering) const;
 
     /** @brief Get the total optical depth for the given wavelength
      *
      * @see ComputeAtmosphereOpacity KlettInversion
      * @param wl the wavelength as an integer 
     */
-    Float_t GetOD(Int_t wl) {return GetOD(wl,"T");}
+    Float_t GetOD(Int_t wl) const {return GetOD(wl,"T");}
 
     /** @brief Get the Rayleigh scattering optical depth for a given wavelength
      *
      * @see ComputeAtmosphereOpacity KlettInversion
      * @param wl the wavelength as an integer 
     */
-    Float_t GetRayleighOD(Int_t wl) {return GetOD(wl,"M");}
+    Float_t GetRayleighOD(Int_t wl) const {return GetOD(wl,"M");}
 
     /** @brief Get the aerosol optical depth for the given wavelength
      * 
@@ -571,14 +1383,17 @@ namespace LidarTools {
      * @see ComputeAtmosphereOpacity Fernald84
      * @param wl the wavelength as an integer 
     */
-    Float_t GetAOD(Int_t wl)          {return GetOD(wl,"P");}
+    Float_t GetAOD(Int_t wl) const   {return GetOD(wl,"P");}
     
     /** @brief Get the Model total optical depth for the given wavelength
      *
      * @see ComputeAtmosphereOpacity KlettInversion
      * @param wl the wavelength as an integer 
     */
-    Float_t GetModelOD(Int_t wl)           {return fODModelMap[wl];}
+    Float_t GetModelOD(Int_t wl) const       {
+		Int_t slot=fChannels.GetSlot(wl);
+		return slot>=0 ? fResults[slot].fODModel : 0;
+		}
 
     /** @brief Get the model AOD for the given wavelength
      * 
@@ -587,21 +1402,54 @@ namespace LidarTools {
      * @see ComputeAtmosphereOpacity Fernald84
      * @param wl the wavelength as an integer 
     */
-    Float_t GetModelAOD(Int_t wl)          {return fODModelMap_P[wl];}
+    Float_t GetModelAOD(Int_t wl) const      {
+		Int_t slot=fChannels.GetSlot(wl);
+		return slot>=0 ? fResults[slot].fODModel_P : 0;
+		}
 
     /** @brief Get a pointer to the ConfigHandler
      *
      * @see ConfigHandler SetConfig StoreConfigLocally     
     */
     ConfigHandler* GetConfig()         {return fConfig;}
+
+    /** @brief Get the typed parameters of the current configuration
+     *
+     * @see AnalysisConfig ApplyNominalConfig
+    */
+    const AnalysisConfig& GetAnalysisConfig() const {return fCompiledConfig;}
+
+    /** @brief Get the fingerprint of the current configuration
+     *
+     * Equal for two configurations with the same effective parameters.
+     * @see AnalysisConfig::GetFingerprint
+    */
+    ULong64_t GetConfigFingerprint() const {return fCompiledConfig.GetFingerprint();}
+
+    /** @brief Get the return code of the last compile of the configuration
+     *
+     * @see AnalysisConfig::Compile
+    */
+    int GetConfigRc() const {return fConfigRc;}
+
+    /** @brief Get the names of the configuration epochs of the current run,
+     * comma separated, in the order they were applied
+     *
+     * @see ConfigHandler::FindEpochs
+    */
+    std::string GetConfigEpochNames() const;
  
-     /** @brief Get a vector of available wavelength
+     /** @brief Get the vector of processed wavelengths
      *
-     * Now only 355 nm and 532 nm for HESS elastic lidar
-     * 
      * @see Analyser LidarFile
     */
-   std::vector<Int_t> GetWavelengths(){return fWaveLengthVec;}
+   const std::vector<Int_t>& GetWavelengths() const {return fWaveLengthVec;}
+
+    /** @brief Get the channel registry, wavelength to slot index
+     *
+     * @see ChannelRegistry
+    */
+    const ChannelRegistry& GetChannels() const {return fChannels;}
 
     /** @brief Get a pointer to the AtmoAbsorption
      *
@@ -610,6 +1458,141 @@ namespace LidarTools {
   
   private:
 
+    /** @brief Apply the epochs of the run to the nominal configuration,
+     * then the overrides of OverwriteConfigParam, copy it to the working
+     * one, and store it locally
+     *
+     * The configuration is compiled again only if the nominal one or the
+     * epochs of the run changed.
+     *
+     * @return as StoreConfigLocally, the errors of the configuration are
+     *         only reported, see GetConfigRc
+     * @see fNominalConfig AnalysisConfig StoreConfigLocally
+     */
+    int ApplyNominalConfig();
+
+    /** @brief Reset per-run results, keep allocated arrays
+     *
+     */
+    void ResetRunState();
+
+    /** @brief Build the prefix sums of the power, or of the filtered power,
+     *  of a channel slot
+     */
+    void BuildPowerSums(Int_t slot);
+
+    /** @brief Find the samples of each bin from the bin edges
+     *
+     * @param edges the bin edges, nbins+1 values
+     * @param nbins the number of bins
+     * @param first the first sample of each bin, nbins values
+     * @param end the sample after the last one of each bin, nbins values
+     */
+    void FindBinSamples(const Float_t* edges, Int_t nbins, Int_t* first, Int_t* end) const;
+
+    /** @brief Samples of the current bins, from fBinsAltitude */
+    void SetBinsSamples();
+
+    /** @brief Fill the binned power and its standard deviation
+     *  from the prefix sums, for the current bins
+     */
+    void FillBinnedPower(Int_t slot);
+
+    /** @brief Process data for the given wavelength, whatever the retention
+     *
+     * @param wl the wavelength as an integer
+     */
+    int ProcessChannel(Int_t wl);
+
+    /** @brief Process data for two wavelengths with the joint inversion,
+     *  a channel alone is inverted as usual if the other one fails
+     *
+     * @param wl1 the first wavelength as an integer
+     * @param wl2 the second wavelength as an integer
+     */
+    int ProcessJoint(Int_t wl1, Int_t wl2);
+
+    /** @brief Pre-scan, classification, binning and optimizations,
+     *  up to the inversion
+     *
+     * @param wl the wavelength as an integer
+     * @return 0 if OK, 1 if rejected, >0 if an optimization failed
+     */
+    int PrepareChannel(Int_t wl);
+
+    /** @brief Inversion and uncertainties of a prepared wavelength
+     *
+     * @param wl the wavelength as an integer
+     */
+    int InvertChannel(Int_t wl);
+
+    /** @brief Uncertainties of an inverted wavelength, and configuration dump
+     *
+     * @param wl the wavelength as an integer
+     */
+    void FinishChannel(Int_t wl);
+
+    /** @brief Precompute range and overlap factors of the analysis window
+     *
+     * @see PreScan
+     */
+    void InitGeometry();
+
+    /** @brief Precompute the Savitzky-Golay derivative coefficients
+     *
+     * @see DetectLayers
+     */
+    void InitLayerFilter();
+
+    /** @brief Pre-scan minimum and saturation in [from,to)
+     *
+     * @param signal the raw signal
+     * @param from first index
+     * @param to index after the last one
+     * @param stats statistics to update
+     */
+    void ScanRaw(const Float_t* signal, Int_t from, Int_t to, PreScanStats& stats) const;
+
+    /** @brief Pre-scan power in [from,to) of the analysis window
+     *
+     * @param signal the raw signal
+     * @param from first index
+     * @param to index after the last one
+     * @param bkg the background value
+     * @param reduced the reduced signal output, may be 0
+     * @param pw the power output
+     * @param stats minimum and saturation to update, 0 if already counted
+     */
+    void ScanPower(const Float_t* signal, Int_t from, Int_t to, Float_t bkg,
+                   Float_t* reduced, Float_t* pw, PreScanStats* stats) const;
+
+    /** @brief Free the arrays not needed anymore at a given step
+     *
+     * @param step 0 after data preparation, 1 after one wavelength,
+     *             2 after all wavelengths
+     * @see Retention
+     */
+    void ApplyRetention(Int_t step);
+
+    /** @brief Read per channel parameters from the working configuration
+     *
+     * @see ChannelParams
+     */
+    void StoreChannelConfigLocally();
+
+    /** @brief Select the total, molecules or particles product
+     *
+     * @param scattering kind of profile (total "T", Molecules "M", Mie "P")
+     */
+    static const ChannelBuffer& SelectProduct(const ChannelBuffer& total,
+                                              const ChannelBuffer& molecules,
+                                              const ChannelBuffer& particles,
+                                              const std::string& scattering) {
+		if (scattering=="P")      return particles;
+		else if (scattering=="M") return molecules;
+		else                      return total;
+		}
+
     /** @brief Init  LidarTools::AtmoProfile that describes the atmosphere
      * profile
      *
@@ -624,9 +1607,14 @@ namespace LidarTools {
     /** @brief Init LidarTools::Overlap for the overlap function correction */
     void InitOverlap();
 
+    /** @brief Init LidarTools::AODTable, the external AOD of each run */
+    void InitAODTable();
+
     /** @brief LidarTools::doOptimizeRO for a given wavelength
      *  so that S/N ratio be above threshold - changes fParamR0_wl
      *
+     *  R0 is also moved below the lowest layer if R0BelowLayers is set.
+     *
      * @param wl the wavelength as an integer 
      */
     int doOptimizeR0(Int_t);
@@ -638,6 +1626,13 @@ namespace LidarTools {
      */
     int doOptimizeAC(Int_t);
 
+    /** @brief LidarTools::doSolveSp for a given wavelength
+     *  to set fParamFSp_wl from the external AOD of the run - changes fParamFSp_wl
+     *
+     * @param wl the wavelength as an integer 
+     */
+    int doSolveSp(Int_t);
+
     /** @brief LidarTools::PureRayleighInversion for a given wavelength
      *  to test a mis-alignment correction factor
      *
@@ -646,8 +1641,124 @@ namespace LidarTools {
      */
     Float_t PureRayleighInversion(Int_t, Float_t);
 
+    /** @brief Pure Rayleigh inversions for many correction factors
+     *  in one batched Fernald inversion
+     *
+     * @param wl the wavelength as an integer
+     * @param lanes the number of correction factors
+     * @param alignCorr the correction factors
+     * @param residuals the mean squared particle extinction from R0
+     *  down to OptimizeAC_Hmin for each factor
+     * @return 0 if OK, 1 if less than 2 bins below R0
+     */
+    int PureRayleighResiduals(Int_t wl, Int_t lanes, const Float_t* alignCorr,
+                              Double_t* residuals);
+
+    /** @brief fill the inputs common to all inversions, on the arena
+     *
+     * @param wl the wavelength as an integer
+     * @param in the inversion inputs
+     * @param withModel also compute the model extinction
+     * @return 0 if OK, 1 if less than 2 bins below R0
+     */
+    int PrepareInversionInput(Int_t wl, InversionInput& in, Bool_t withModel);
+
+    /** @brief Number of bins up to the reference, the nearest to R0
+     *
+     * @param wl the wavelength as an integer
+     */
+    Int_t GetNBinsBelowR0(Int_t wl) const;
+
+    /** @brief Set the binned power and the parameters of the inversion inputs
+     *
+     * @param wl the wavelength as an integer
+     * @param in the inversion inputs
+     */
+    void SetInversionParams(Int_t wl, InversionInput& in);
+
+    /** @brief Set the parameters of the optimal estimation in the inversion inputs
+     *
+     * @param in the inversion inputs
+     */
+    void SetOEParams(InversionInput& in) const;
+
+    /** @brief run an inversion for the given wavelength from prepared inputs,
+     *  scratch arrays are taken from the arena and not rewound
+     *
+     * @param wl the wavelength as an integer
+     * @param inversion the algorithm
+     * @param in the inputs, the error inputs are set here
+     * @return 0 if OK
+     */
+    int Invert(Int_t wl, const Inversion& inversion, InversionInput& in);
+
+    /** @brief Slabs between bin centers and profiles at their altitude,
+     *  the last of the n values is the reference, between the last two centers
+     *
+     * @param wl the wavelength as an integer
+     * @param n the number of bins up to the reference
+     * @param altitude the altitude of each slab
+     * @param thickness the thickness of each slab
+     * @param alpha_mol the molecular extinction
+     * @param alpha_model the model extinction, may be 0
+     */
+    void FillSlabs(Int_t wl, Int_t n, Float_t* altitude, Float_t* thickness,
+                   Float_t* alpha_mol, Float_t* alpha_model);
+
+    /** @brief Nearest rank percentile, values are reordered
+     *
+     * @param values the values
+     * @param n the number of values
+     * @param q the fraction, from 0 to 1
+     * @return the percentile, 0 if n is 0
+     */
+    static Float_t Percentile(Float_t* values, Int_t n, Float_t q);
+
+    /** @brief Error of the binned power, the standard deviation of each
+     *  bin over the square root of its number of samples
+     *
+     * @param slot the channel slot
+     * @param n the number of bins
+     * @param err the errors
+     */
+    void FillBinnedPowErr(Int_t slot, Int_t n, Float_t* err);
+
+    /** @brief Width of each bin overlapping [TauAltMin, TauAltMax], 0 for
+     *  the others, the weights of the optical depth
+     *
+     * @param n the number of bins
+     * @param weights the weights
+     */
+    void FillODWeights(Int_t n, Float_t* weights);
+
+    /** @brief Derivative of the binned power with the background, the mean
+     *  over each bin of -range^2/overlap, with the sign of signal-bkg
+     *
+     * @param slot the channel slot
+     * @param n the number of bins
+     * @param dpdbkg the derivatives
+     */
+    void FillPowerBkgDerivative(Int_t slot, Int_t n, Float_t* dpdbkg);
+
+    /** @brief replicate the inputs for a batched Fernald inversion
+     *  and allocate its outputs, on the arena
+     *
+     * @param in the inversion inputs
+     * @param lanes the number of inversions
+     * @param Sp the particle lidar ratios
+     * @param sratio the scattering ratios at R0
+     * @param alignCorr the correction factors
+     * @param out the outputs, lanes values per bin
+     * @return the batch inputs
+     */
+    FernaldBatchInput MakeFernaldBatch(const InversionInput& in, Int_t lanes,
+                                       const Float_t* Sp, const Float_t* sratio,
+                                       const Float_t* alignCorr, InversionOutput& out);
+
     /** @brief boolean to print some results if true */
     Bool_t fVerbose;
+    /** @brief What is kept in memory once processed */
+    Retention fRetention; //!
     
     /** @brief the run number */
     Int_t fRunNumber;
@@ -656,18 +1767,47 @@ namespace LidarTools {
     
     /** @brief the time */
     time_t fTimeStamp;
+    /** @brief the time as a string, see GetTimeString */
+    char fTimeString[32];
 
-    /** @brief Vector of available wave length */
+    /** @brief Vector of processed wave length */
     std::vector<Int_t> fWaveLengthVec;
+
+    /** @brief Wavelength to channel slot map */
+    ChannelRegistry fChannels;
+    /** @brief Per channel parameters, indexed by slot */
+    std::vector<ChannelParams> fParams;
+    /** @brief Per channel scalar results, indexed by slot */
+    std::vector<ChannelResults> fResults;
     
-    /** @brief Raw altitude in km above Lidar */
-    TArrayF fRawRange;
+    /** @brief Raw data of the current shot, shared read-only */
+    std::shared_ptr<const LidarShot> fShot; //!
+    /** @brief Raw altitude in km above Lidar, view on fShot */
+    FloatView fRawRange; //!
     
     /** @brief Altitude in km above Lidar corrected for zenith angle inclination */
     TArrayF fRange;
 
-    /** @brief Configuration handler */
+    /** @brief Configuration handler, as actually used for the current shot */
     ConfigHandler *fConfig;
+    /** @brief Nominal configuration, as set by the user, restored for each new shot */
+    ConfigHandler *fNominalConfig;
+    /** @brief Typed parameters, compiled from fConfig by ApplyNominalConfig */
+    AnalysisConfig fCompiledConfig; //!
+    /** @brief Parameters set by OverwriteConfigParam, applied after the epochs */
+    std::map<std::string, std::string> fConfigOverrides; //!
+    /** @brief Nominal configuration with the epochs of the run and the overrides applied */
+    ConfigHandler fResolvedConfig; //!
+    /** @brief Epochs applied to fResolvedConfig */
+    std::vector<Int_t> fConfigEpochs; //!
+    /** @brief fResolvedConfig and fCompiledConfig are up to date with fNominalConfig */
+    Bool_t fConfigResolved; //!
+    /** @brief Return code of the last Compile */
+    int fConfigRc; //!
+    /** @brief Range, indices and geometry of the shot are initialized */
+    Bool_t fPrepared; //!
+    /** @brief Preparation fingerprint of the configuration they were initialized with */
+    ULong64_t fPreparedFingerprint; //!
 
     /** @brief overlap function*/
     LidarTools::Overlap *fOverlap;
@@ -676,66 +1816,67 @@ namespace LidarTools {
     /** @brief apply overlap */
     bool fApplyOverlap;
 
-    /** @brief Raw data map */
-    std::map<Int_t, TArrayF> fSignalMap;
-    /** @brief Data Quality map */
-    std::map<Int_t, Bool_t> fQualityMap;    
-    /** @brief Background map */
-    std::map<Int_t, Float_t> fBkgMap;
-    /** @brief Background map */
-    std::map<Int_t, TArrayF> fFullBkgMap;
-    /** @brief Reduced signal map */
-    std::map<Int_t, TArrayF> fReducedSignalMap;
-    /** @brief power signal map */
-    std::map<Int_t, TArrayF> fPowMap;
-    /** @brief ln power signal map */
-    std::map<Int_t, TArrayF> fLnPowMap;
-    /** @brief filtered power signal map */
-    std::map<Int_t, TArrayF> fFilteredPowMap;
-    /** @brief ln(filtered(power)) signal map */
-    std::map<Int_t, TArrayF> fLnFilteredPowMap;
-    /** @brief Binned signal map */
-    std::map<Int_t, TArrayF> fBinnedPowMap;
-    /** @brief Binned signal standard deviation map */
-    std::map<Int_t, TArrayF> fBinnedPowDevMap;
-    /** @brief Alpha0 map */
-    std::map<Int_t, Float_t> fParamAlpha0Map;
-    /** @brief Extinction map */
-    std::map<Int_t, TArrayF> fAlphaMap;
-    /** @brief Extinction map for molecules - Rayleigh scattering*/
-    std::map<Int_t, TArrayF> fAlphaMap_M;
-    /** @brief Extinction map for particules - Mie scattering */
-    std::map<Int_t, TArrayF> fAlphaMap_P;
-    /** @brief Backscatter map */
-    std::map<Int_t, TArrayF> fBetaMap;
-    /** @brief Backscatter map for molecules - Rayleigh scattering*/
-    std::map<Int_t, TArrayF> fBetaMap_M;
-    /** @brief Backscatter map for particules - Mie scattering */
-    std::map<Int_t, TArrayF> fBetaMap_P;
-    /** @brief Opacity profile map */
-    std::map<Int_t, TArrayF> fOpacityMap;
-    /** @brief Opacity profile map  - Rayleigh scattering */
-    std::map<Int_t, TArrayF> fOpacityMap_M;
-    /** @brief Opacity profile map  - Mie scattering */
-    std::map<Int_t, TArrayF> fOpacityMap_P;
-    /** @brief Transmission profile map */
-    std::map<Int_t, TArrayF> fTransmissionMap;
-    /** @brief OD map */
-    std::map<Int_t, Float_t> fODMap;
-    /** @brief OD map for Rayleigh scattering */
-    std::map<Int_t, Float_t> fODMap_M;
-    /** @brief OD map for Mie scattering */
-    std::map<Int_t, Float_t> fODMap_P;    
-    /** @brief Extinction map for atmosphere transmission model */
-    std::map<Int_t, TArrayF> fAlphaModelMap;
-    /** @brief Opacity model profile map */
-    std::map<Int_t, TArrayF> fOpacityModelMap;
-    /** @brief Transmission model profile map */
-    std::map<Int_t, TArrayF> fTransmissionModelMap;
-    /** @brief OD map for Model */
-    std::map<Int_t, Float_t> fODModelMap;
-    /** @brief OD map for Model - Mie scattering */
-    std::map<Int_t, Float_t> fODModelMap_P;
+    /** @brief Raw data, views on fShot indexed by slot */
+    std::vector<FloatView> fRawSignal; //!
+
+    /** @brief Scratch memory of the inversions, reset by Load */
+    Arena fArena; //!
+
+    /* Products, one slot per channel */
+    /** @brief Raw data in the background window */
+    ChannelBuffer fFullBkg;
+    /** @brief Reduced signal */
+    ChannelBuffer fReducedSignal;
+    /** @brief power signal */
+    ChannelBuffer fPow;
+    /** @brief filtered power signal */
+    ChannelBuffer fFilteredPow;
+    /** @brief Prefix sums of the binned input, power or filtered power */
+    PowerSums fPowSums; //!
+    /** @brief Binned signal */
+    ChannelBuffer fBinnedPow;
+    /** @brief Binned signal standard deviation */
+    ChannelBuffer fBinnedPowDev;
+    /** @brief Extinction */
+    ChannelBuffer fAlpha;
+    /** @brief Extinction for molecules - Rayleigh scattering*/
+    ChannelBuffer fAlpha_M;
+    /** @brief Extinction for particules - Mie scattering */
+    ChannelBuffer fAlpha_P;
+    /** @brief Backscatter */
+    ChannelBuffer fBeta;
+    /** @brief Backscatter for molecules - Rayleigh scattering*/
+    ChannelBuffer fBeta_M;
+    /** @brief Backscatter for particules - Mie scattering */
+    ChannelBuffer fBeta_P;
+    /** @brief Opacity profile */
+    ChannelBuffer fOpacity;
+    /** @brief Opacity profile - Rayleigh scattering */
+    ChannelBuffer fOpacity_M;
+    /** @brief Opacity profile - Mie scattering */
+    ChannelBuffer fOpacity_P;
+    /** @brief Transmission profile */
+    ChannelBuffer fTransmission;
+    /** @brief Transmission profile - Rayleigh scattering */
+    ChannelBuffer fTransmission_M;
+    /** @brief Transmission profile - Mie scattering */
+    ChannelBuffer fTransmission_P;
+    /** @brief Extinction for atmosphere transmission model */
+    ChannelBuffer fAlphaModel;
+    /** @brief Opacity model profile */
+    ChannelBuffer fOpacityModel;
+    /** @brief Transmission model profile */
+    ChannelBuffer fTransmissionModel;
+    /** @brief 16th percentile of the extinction over the ensemble */
+    ChannelBuffer fEnsembleAlpha16;
+    /** @brief Median of the extinction over the ensemble */
+    ChannelBuffer fEnsembleAlpha50;
+    /** @brief 84th percentile of the extinction over the ensemble */
+    ChannelBuffer fEnsembleAlpha84;
+    /** @brief First order error of the total extinction */
+    ChannelBuffer fAlphaErr;
+    /** @brief First order error of the total backscatter */
+    ChannelBuffer fBetaErr;
 
     /** @brief N points in altitude range */
     Int_t fN;
@@ -745,6 +1886,14 @@ namespace LidarTools {
     Int_t fAltMinIndex;
     /** @brief Index of max altitude */
     Int_t fAltMaxIndex;
+    /** @brief Index of the first sample of the background window */
+    Int_t fBkgMinIndex;
+    /** @brief Index after the last sample of the background window */
+    Int_t fBkgMaxIndex;
+    /** @brief Effective range in meters of the analysis window samples */
+    TArrayF fGeomRange;
+    /** @brief Overlap correction of the analysis window samples, empty if not applied */
+    TArrayF fGeomOverlap;
    
     /** @brief Altitude array in meters above sea level */
     TArrayF fAltitude;
@@ -753,8 +1902,17 @@ namespace LidarTools {
     /** @brief Center Altitude bins array */
     TArrayF fBinsCenterAltitude;
 
+    /** @brief Wavelengths of the last joint inversion, 0 if none */
+    Int_t fJointWl[2];
+    /** @brief Angstrom exponent profile of the last joint inversion */
+    TArrayF fAngstromExp;
+    /** @brief Colour ratio profile of the last joint inversion */
+    TArrayF fColourRatio;
+
     /** @brief Choose reconstruction algorithm */
     std::string fAlgName;
+    /** @brief Inversion for fAlgName, resolved once per configuration, 0 if unknown */
+    const Inversion* fInversion; //!
     
     /** @brief boolean to optimize automatically the choice of R0 */
     Bool_t fParamOptimizeR0;
@@ -784,16 +1942,26 @@ namespace LidarTools {
     UInt_t fParamNBins;
     /** @brief Use Logarithmic binning in altitude ? */
     Bool_t fParamLogBins;
+    /** @brief Use adaptive binning in altitude ? */
+    Bool_t fParamAdaptiveBins;
+    /** @brief Target S/N of the adaptive bins */
+    Float_t fParamAdaptiveBinsSNR;
+    /** @brief Nb of bins of the current binning, NBins is never modified */
+    UInt_t fNBins;
+    /** @brief First sample of each bin, empty until the first channel
+     *  of the shot is binned */
+    std::vector<Int_t> fBinsFirstSample; //!
+    /** @brief Sample after the last one of each bin, bins overlap for
+     *  the gliding average */
+    std::vector<Int_t> fBinsEndSample; //!
     /** @brief Apply Savitsky-Golay filter ? */
     Bool_t fParamSGFilter;
 
     /* See Klett inversion method */    
-    /** @brief Reference Altitude for 355 nm */
-    Float_t fParamR0_355;      
-    /** @brief Reference Altitude for 532 nm */
-    Float_t fParamR0_532;      
     /** @brief as in beta=l*alpha^k */
     Float_t fParamKlett_k;
+    /** @brief Klett recurrence specialized for fParamKlett_k, chosen once per configuration */
+    KlettKernel fKlettKernel; //!
     /** @brief as in beta=l*alpha^k */
     Float_t fParamKlett_l;
     /** @brief Minimum altitude from which to integrate the atmosphere opacity */
@@ -802,20 +1970,93 @@ namespace LidarTools {
     Float_t fTauAltMax;
     
     /* See Fernald84 inversion method */
-    /** @brief Sp=alpha_p/beta_p extinction-to-backscatter ratio at 355 nm*/
-    Float_t fFernald84_Sp355;
-    /** @brief Sp=alpha_p/beta_p extinction-to-backscatter ratio at 532 nm*/
-    Float_t fFernald84_Sp532;
     /** @brief sratio=1+Sp/Sr */
     Float_t fFernald84_sratio;
     
     /** @brief Signal To Noise Ratio threshold to start intergration */
     Float_t fSNRatioThreshold;
 
-    /** @brief Mis-Alignment correction factor for 355 nm */
-    Float_t fParamAlignCorr_355;
-    /** @brief Mis-Alignment correction factor for 532 nm */
-    Float_t fParamAlignCorr_532;
+    /* See Classify */
+    /** @brief Number of coarse bins of the analysis window */
+    Int_t fClassifyNCoarse;
+    /** @brief Minimal S/N per sample of a coarse bin */
+    Float_t fClassifyMinSNR;
+    /** @brief Altitude above the Lidar below which the signal may not be lost, in m */
+    Float_t fClassifyMinSignalAlt;
+    /** @brief Maximal background drift in %, 0 to disable */
+    Float_t fClassifyBkgDriftMax;
+    /** @brief Maximal background RMS in V, 0 to disable */
+    Float_t fClassifyBkgRMSMax;
+    /** @brief Consecutive samples at the trace minimum of a clipped shot, 0 to disable */
+    Int_t fClassifyClipRun;
+    /** @brief Reasons that reject a shot, bits of ShotClass::Reason */
+    UInt_t fClassifyRejectMask;
+
+    /* See DetectLayers */
+    /** @brief Half width in samples of the derivative window */
+    Int_t fLayerHalfWidth;
+    /** @brief Threshold on the derivative of ln(power), per km */
+    Float_t fLayerThreshold;
+    /** @brief Minimal mean S/N per sample in the derivative window */
+    Float_t fLayerMinSNR;
+    /** @brief Minimal increase of ln(power) from base to peak */
+    Float_t fLayerMinStrength;
+    /** @brief Move R0 below the lowest layer when optimizing R0 */
+    Bool_t fParamR0BelowLayers;
+    /** @brief Savitzky-Golay first derivative coefficients, 2*fLayerHalfWidth+1 */
+    std::vector<Float_t> fLayerCoeffs;
+
+    /* See RunEnsemble */
+    /** @brief Number of Monte Carlo replicas, 0 to disable */
+    Int_t fParamEnsembleSize;
+    /** @brief Seed of the replicas random streams */
+    Int_t fParamEnsembleSeed;
+    /** @brief Number of threads, 0 for all hardware threads */
+    Int_t fParamEnsembleThreads;
+    /** @brief Prior width of Sp, in sr */
+    Float_t fParamEnsembleSpSigma;
+    /** @brief Prior width of sratio */
+    Float_t fParamEnsembleSratioSigma;
+    /** @brief Prior width of R0, in m */
+    Float_t fParamEnsembleR0Sigma;
+    /** @brief Prior width of the background fudge factor */
+    Float_t fParamEnsembleBkgFFactorSigma;
+    /** @brief Propagate the binned power errors through the inversions */
+    Bool_t fParamPropagateErrors;
+    /** @brief Compute the derivatives of the optical depths */
+    Bool_t fParamSensitivities;
+
+    /* See SolveSp */
+    /** @brief Retrieve Sp from the external AOD of the run */
+    Bool_t fParamSpSolve;
+    /** @brief Tolerance on Sp, in sr */
+    Float_t fParamSpSolveTolerance;
+    /** @brief Maximal number of iterations */
+    Int_t fParamSpSolveMaxIter;
+    /** @brief Lower end of the Sp bracket, in sr */
+    Float_t fParamSpSolveMin;
+    /** @brief Upper end of the Sp bracket, in sr */
+    Float_t fParamSpSolveMax;
+    /** @brief Largest time between run and external observation, in hours */
+    Float_t fParamSpSolveMaxHours;
+
+    /* See InvertJoint */
+    /** @brief Invert JointWl1 and JointWl2 jointly */
+    Bool_t fParamJointInversion;
+    /** @brief First wavelength of the joint inversion */
+    Int_t fParamJointWl1;
+    /** @brief Second wavelength of the joint inversion */
+    Int_t fParamJointWl2;
+
+    /* See OptimalEstimationAlgorithm */
+    /** @brief Weight of the second differences of beta_p/beta_m */
+    Float_t fParamOESmoothing;
+    /** @brief Prior width of beta_p/beta_m */
+    Float_t fParamOEPriorSigma;
+    /** @brief Maximal number of Gauss-Newton iterations */
+    Int_t fParamOEMaxIter;
+    /** @brief Largest step of beta_p/beta_m at convergence */
+    Float_t fParamOETolerance;
     
     /** @brief Atmospheric Absorption.
       *
@@ -837,6 +2078,15 @@ namespace LidarTools {
      *  atmprof10.dat
      */
     std::string fAtmoFileName;
+
+    /** @brief External AOD of each run, read once when SpSolve is set */
+    AODTable* fAODTable; //!
+
+    /** @brief External AOD table file name */
+    std::string fAODTableFileName;
+
+    /** @brief Threads of the Monte Carlo ensemble, created on first use */
+    ThreadPool* fPool; //!
     
   protected:
     
@@ -0,0 +1,270 @@
+/** @file AnalysisConfig.hh
+ *
+ * @brief AnalysisConfig class definition
+ *
+ * Typed analysis parameters, compiled once from a ConfigHandler
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_ANALYSISCONFIG
+#define LIDARTOOLS_ANALYSISCONFIG
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ConfigHandler.hh"
+
+namespace LidarTools {
+
+/** @class AnalysisConfig
+ *
+ * @brief All analysis parameters with their types, parsed, checked and
+ *  fingerprinted in one pass over a ConfigHandler
+ *
+ * The members are named after the configuration keys. Compile parses each
+ * known key once, reports values that are not numbers, out of range or
+ * inconsistent with each other, and keys that are not known. Store writes
+ * the canonical values back, so that "1." and "1" end up the same.
+ *
+ * The fingerprint is a 64 bit FNV-1a hash of the canonical key=value
+ * pairs sorted by key, numbers with all their significant digits. Two
+ * configurations with the same effective parameters have the same
+ * fingerprint, on any platform.
+ *
+ * @see ConfigHandler Analyser::GetConfigFingerprint
+*/
+  struct AnalysisConfig
+  {
+    /** @brief Constructor, default configuration of ConfigHandler */
+    AnalysisConfig();
+
+    /** @brief Destructor */
+    virtual ~AnalysisConfig() {}
+
+    /** @brief Parse and check all parameters of a configuration
+     *
+     * Parameters that are not numbers are set to their leading number or
+     * to 0, as atof would, all others are set even if out of range. Errors
+     * are only reported.
+     *
+     * @param handler the configuration
+     * @return 0 if OK, 1 if a value is not a number,
+     *         2 if a value is out of range or inconsistent
+     */
+    int Compile(const ConfigHandler& handler);
+
+    /** @brief Write the canonical values of all parameters, with the
+     *  precision of the fingerprint so that they are read back unchanged
+     *
+     * @param handler the configuration
+     */
+    void Store(ConfigHandler& handler) const;
+
+    /** @brief Return the fingerprint of the parameters of the last Compile */
+    ULong64_t GetFingerprint() const      {return fFingerprint;}
+
+    /** @brief Return the fingerprint as 16 hexadecimal digits */
+    std::string GetFingerprintString() const;
+
+    /** @brief Return the fingerprint of the parameters of the shot
+     *  preparation only, up to the early classification
+     *
+     * Configurations with the same one can share the range, geometry,
+     * pre-scan and layers of a shot.
+     */
+    ULong64_t GetPrepareFingerprint() const {return fPrepareFingerprint;}
+
+    /** @brief Return R0 at a given wavelength, 0 if not set */
+    Float_t GetR0(Int_t wl) const         {return GetChannelValue(fR0, wl, 0.);}
+    /** @brief Return the Fernald Sp at a given wavelength, 50 if not set */
+    Float_t GetFernald_Sp(Int_t wl) const {return GetChannelValue(fFernald_Sp, wl, 50.);}
+    /** @brief Return the alignment correction at a given wavelength, 0 if not set */
+    Float_t GetAlignCorr(Int_t wl) const  {return GetChannelValue(fAlignCorr, wl, 0.);}
+
+    /* Lidar and signal */
+    /** @brief Lidar altitude above sea level, in m */
+    Float_t fLidarAltitude;
+    /** @brief Lidar inclination, in degrees */
+    Int_t fLidarTheta;
+    /** @brief Threshold in V to be reached by good data */
+    Float_t fQualityThr;
+    /** @brief Lowest altitude of the signal, in m */
+    Float_t fAltMin;
+    /** @brief Highest altitude of the signal, in m */
+    Float_t fAltMax;
+    /** @brief Lowest altitude of the background, in m */
+    Float_t fBkgMin;
+    /** @brief Highest altitude of the background, in m */
+    Float_t fBkgMax;
+    /** @brief Background fudge factor */
+    Float_t fBkgFudgeFactor;
+    /** @brief Number of altitude bins */
+    UInt_t fNBins;
+    /** @brief Logarithmic bins */
+    Bool_t fLogBins;
+    /** @brief Bins grow with altitude to reach AdaptiveBinsSNR */
+    Bool_t fAdaptiveBins;
+    /** @brief Target S/N of the adaptive bins */
+    Float_t fAdaptiveBinsSNR;
+    /** @brief Savitzky-Golay filter of the power */
+    Bool_t fSGFilter;
+    /* Inversion */
+    /** @brief Klett exponent */
+    Float_t fKlett_k;
+    /** @brief Klett factor */
+    Float_t fKlett_l;
+    /** @brief Lowest altitude of the optical depth, in m */
+    Float_t fTauAltMin;
+    /** @brief Highest altitude of the optical depth, in m */
+    Float_t fTauAltMax;
+    /** @brief Scattering ratio at the reference, 1+beta_p/beta_m */
+    Float_t fFernald_sratio;
+    /** @brief Inversion algorithm name */
+    std::string fAlgName;
+    /** @brief Minimal S/N at R0 */
+    Float_t fSNRatioThreshold;
+    /** @brief Optimize R0 */
+    Bool_t fOptimizeR0;
+    /** @brief Optimize the alignment correction */
+    Bool_t fOptimizeAC;
+    /** @brief Lowest altitude of the alignment correction fit, in m */
+    Float_t fOptimizeAC_Hmin;
+    /* Early classification and layers */
+    /** @brief Number of coarse bins of the classification */
+    Int_t fClassifyNCoarse;
+    /** @brief Minimal coarse S/N */
+    Float_t fClassifyMinSNR;
+    /** @brief Lowest altitude where the signal may be lost, in m */
+    Float_t fClassifyMinSignalAlt;
+    /** @brief Largest background drift, in % */
+    Float_t fClassifyBkgDriftMax;
+    /** @brief Largest background RMS, 0 to disable */
+    Float_t fClassifyBkgRMSMax;
+    /** @brief Consecutive samples at the trace minimum of a clipped shot, 0 to disable */
+    Int_t fClassifyClipRun;
+    /** @brief Reasons that reject a shot */
+    UInt_t fClassifyRejectMask;
+    /** @brief Half width of the layer derivative filter, in samples */
+    Int_t fLayerHalfWidth;
+    /** @brief Layer threshold on the log power derivative, per km */
+    Float_t fLayerThreshold;
+    /** @brief Minimal S/N of a layer */
+    Float_t fLayerMinSNR;
+    /** @brief Minimal strength of a layer */
+    Float_t fLayerMinStrength;
+    /** @brief Keep R0 below the detected layers */
+    Bool_t fR0BelowLayers;
+    /* Uncertainties */
+    /** @brief Number of Monte Carlo replicas, 0 to disable */
+    Int_t fEnsembleSize;
+    /** @brief Seed of the replicas */
+    Int_t fEnsembleSeed;
+    /** @brief Number of threads, 0 for all */
+    Int_t fEnsembleThreads;
+    /** @brief Prior width of Sp, in sr */
+    Float_t fEnsembleSpSigma;
+    /** @brief Prior width of sratio */
+    Float_t fEnsembleSratioSigma;
+    /** @brief Prior width of R0, in m */
+    Float_t fEnsembleR0Sigma;
+    /** @brief Prior width of the background fudge factor */
+    Float_t fEnsembleBkgFFactorSigma;
+    /** @brief Propagate the binned power errors */
+    Bool_t fPropagateErrors;
+    /** @brief Derivatives of the optical depths */
+    Bool_t fSensitivities;
+    /* Sp from an external AOD */
+    /** @brief Retrieve Sp from the external AOD */
+    Bool_t fSpSolve;
+    /** @brief Tolerance on Sp, in sr */
+    Float_t fSpSolveTolerance;
+    /** @brief Maximal number of iterations on Sp */
+    Int_t fSpSolveMaxIter;
+    /** @brief Lower end of the Sp range, in sr */
+    Float_t fSpSolveMin;
+    /** @brief Upper end of the Sp range, in sr */
+    Float_t fSpSolveMax;
+    /** @brief Largest time to the external observation, in hours */
+    Float_t fSpSolveMaxHours;
+    /* Joint and optimal estimation inversions */
+    /** @brief Joint inversion of JointWl1 and JointWl2 */
+    Bool_t fJointInversion;
+    /** @brief First wavelength of the joint inversion */
+    Int_t fJointWl1;
+    /** @brief Second wavelength of the joint inversion */
+    Int_t fJointWl2;
+    /** @brief Optimal estimation weight of the second differences */
+    Float_t fOESmoothing;
+    /** @brief Optimal estimation prior width of beta_p/beta_m */
+    Float_t fOEPriorSigma;
+    /** @brief Optimal estimation maximal number of iterations */
+    Int_t fOEMaxIter;
+    /** @brief Optimal estimation convergence tolerance */
+    Float_t fOETolerance;
+    /* Data files */
+    /** @brief Atmospheric transmission file */
+    std::string fAtmoAbsorption;
+    /** @brief Atmospheric profile file */
+    std::string fAtmoProfile;
+    /** @brief Overlap function file */
+    std::string fOverlapFunction;
+    /** @brief External AOD table file */
+    std::string fAODTable;
+    /* Per wavelength, keys R0_<wl>, Fernald_Sp<wl> and AlignCorr_<wl> */
+    /** @brief Reference altitude R0 by wavelength, in m */
+    std::map<Int_t, Float_t> fR0;
+    /** @brief Fernald Sp by wavelength, in sr */
+    std::map<Int_t, Float_t> fFernald_Sp;
+    /** @brief Alignment correction by wavelength */
+    std::map<Int_t, Float_t> fAlignCorr;
+
+  private:
+    /** @brief Type of a parameter */
+    enum Type {kFloat, kInt, kUInt, kBool, kString};
+    /** @brief Allowed values of a number */
+    enum Bound {kAny, kNonNegative, kPositive};
+
+    /** @brief A known parameter, its key, type, bound and member */
+    struct Spec
+    {
+      const char* fKey;
+      Type        fType;
+      Bound       fBound;
+      void*       fValue;
+    };
+
+    /** @brief Return all known parameters, pointing to the members of this */
+    std::vector<Spec> GetSpecs() const;
+
+    /** @brief Canonical values of all parameters by key
+     *
+     * @param precision the number of significant digits of the numbers,
+     *        0 for the default of the streams
+     */
+    std::map<std::string, std::string> GetCanonical(Int_t precision) const;
+
+    /** @brief Return a per wavelength value, def if not set */
+    static Float_t GetChannelValue(const std::map<Int_t, Float_t>& values, Int_t wl, Float_t def);
+
+    /** @brief Fingerprint of the last Compile */
+    ULong64_t fFingerprint;
+    /** @brief Fingerprint of the preparation parameters of the last Compile */
+    ULong64_t fPrepareFingerprint;
+
+  protected:
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+    ClassDef(LidarTools::AnalysisConfig,1);
+#endif
+
+  }; // class
+
+}; // namespace
+
+#endif
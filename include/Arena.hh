@@ -0,0 +1,143 @@
+/** @file Arena.hh
+ *
+ * @brief Arena class definition
+ *
+ * Bump allocator for the per-shot scratch arrays of the Analyser
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_ARENA
+#define LIDARTOOLS_ARENA
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+namespace LidarTools {
+
+ /** @class Arena
+  *
+  * @brief Bump allocator, reset in O(1) between shots
+  *
+  * Memory is taken from large chunks by moving an offset. Nothing is
+  * freed individually: Rewind gives back everything allocated after a
+  * Marker, Reset gives back everything. When a shot needed more than one
+  * chunk, Reset merges them into a single chunk, so that after the first
+  * shots no heap allocation happens anymore.
+  *
+  * An Arena is not thread safe, each Analyser owns its own.
+  */
+  class Arena
+  {
+
+  public:
+
+    /** @brief Position in the arena, see GetMarker and Rewind */
+    struct Marker {
+      /** @brief chunk index */
+      UInt_t fChunk;
+      /** @brief offset in the chunk */
+      size_t fOffset;
+      /** @brief bytes in use */
+      Long64_t fUsed;
+    };
+
+    /** @brief Constructor
+     *
+     * @param chunkbytes the size of the first chunk
+     * @param verbose a bool for verbosity
+     */
+    Arena(size_t chunkbytes=65536, Bool_t verbose=false);
+
+    /** @brief Destructor, frees all chunks
+     *
+     */
+    virtual ~Arena();
+
+    /** @brief Allocate bytes, aligned on a cache line
+     *
+     * @param bytes the number of bytes
+     * @return a pointer valid until the next Rewind or Reset
+     */
+    void* Allocate(size_t bytes);
+
+    /** @brief Allocate n elements of type T, initialized to 0
+     *
+     * @param n the number of elements
+     */
+    template <typename T> T* Alloc(Int_t n) {
+		T* array=static_cast<T*>(Allocate(n>0 ? n*sizeof(T) : 0));
+		std::fill(array, array+std::max(n, 0), T(0));
+		return array;
+		}
+
+    /** @brief Return the current position */
+    Marker GetMarker() const;
+
+    /** @brief Give back everything allocated after a marker
+     *
+     * @param marker a position returned by GetMarker
+     */
+    void Rewind(const Marker& marker);
+
+    /** @brief Give back everything, reset the peak, memory is kept */
+    void Reset();
+
+    /** @brief Free all chunks */
+    void Release();
+
+    /** @brief Return the number of bytes in use */
+    Long64_t GetUsedBytes() const        {return fUsed;}
+    /** @brief Return the maximum number of bytes in use since the last Reset */
+    Long64_t GetPeakBytes() const        {return fPeak;}
+    /** @brief Return the number of bytes held by the chunks */
+    Long64_t GetCapacity() const         {return fCapacity;}
+
+  private:
+    /** @brief Allocation alignment in bytes */
+    static const size_t kAlignment=64;
+
+    /** @brief A block of memory */
+    struct Chunk {
+      /** @brief memory as allocated */
+      char* fData;
+      /** @brief usable size in bytes, after alignment of the start */
+      size_t fSize;
+      /** @brief first aligned byte */
+      char* fBegin;
+    };
+
+    /** @brief Add a chunk of at least bytes usable bytes */
+    void AddChunk(size_t bytes);
+
+    /** @brief boolean to print some results if true */
+    Bool_t fVerbose;
+    /** @brief size of the first chunk */
+    size_t fChunkBytes;
+    /** @brief all chunks */
+    std::vector<Chunk> fChunks;
+    /** @brief chunk in use */
+    UInt_t fCurrent;
+    /** @brief offset in the chunk in use */
+    size_t fOffset;
+    /** @brief bytes in use */
+    Long64_t fUsed;
+    /** @brief maximum bytes in use since the last Reset */
+    Long64_t fPeak;
+    /** @brief bytes held */
+    Long64_t fCapacity;
+
+    // not copyable
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+
+  }; // class
+
+}; // namespace
+
+#endif
@@ -110,6 +110,16 @@ namespace LidarTools {
      * @param height the altitude in meters
      *  */
     double Extinction(int, double) const;
+
+    /** @brief Ratio of the Rayleigh extinctions at two wavelengths,
+     *  the same at all heights
+     *
+     * Extinction(wl, height)=ExtinctionScale(wl, wlref)*Extinction(wlref, height)
+     * 
+     * @param wl the wavelength
+     * @param wlref the reference wavelength
+     *  */
+    double ExtinctionScale(int, int) const;
     
   private:
     /** @brief boolean to print some results if true */
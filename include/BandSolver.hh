@@ -0,0 +1,85 @@
+/** @file BandSolver.hh
+ *
+ * @brief LDL^T factorization and solves of symmetric band matrices
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_BANDSOLVER
+#define LIDARTOOLS_BANDSOLVER
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <algorithm>
+
+namespace LidarTools {
+
+ /** @brief Symmetric band matrices of half bandwidth w, row i stores
+  *  A(i,i-k) at a[i*(w+1)+k] for k=0..w, the diagonal first.
+  *
+  * Factorization and solves take O(n*w*w), e.g. tridiagonal for w=1
+  * and pentadiagonal for w=2.
+  */
+
+  /** @brief Element (i,j) of a band matrix, j<=i<=j+w */
+  inline Double_t& BandAt(Double_t* a, Int_t w, Int_t i, Int_t j) {return a[i*(w+1)+(i-j)];}
+  /** @brief Element (i,j) of a band matrix, j<=i<=j+w */
+  inline Double_t BandAt(const Double_t* a, Int_t w, Int_t i, Int_t j) {return a[i*(w+1)+(i-j)];}
+
+  /** @brief Factorize A=L*D*L^T in place, D on the diagonal, L below it
+   *
+   * @param a the band matrix, replaced by L and D
+   * @param n the size
+   * @param w the half bandwidth
+   * @return 0 if OK, 1 if A is not positive definite
+   */
+  inline int BandLDLTFactor(Double_t* a, Int_t n, Int_t w)
+  {
+    for(Int_t i=0; i<n; i++){
+      Int_t first=std::max(0, i-w);
+      for(Int_t j=first; j<i; j++){
+        Double_t s=BandAt(a, w, i, j);
+        for(Int_t m=first; m<j; m++)
+          s-=BandAt(a, w, i, m)*BandAt(a, w, j, m)*BandAt(a, w, m, m);
+        BandAt(a, w, i, j)=s/BandAt(a, w, j, j);
+        }
+      Double_t d=BandAt(a, w, i, i);
+      for(Int_t m=first; m<i; m++){
+        Double_t l=BandAt(a, w, i, m);
+        d-=l*l*BandAt(a, w, m, m);
+        }
+      if(!(d>0.))
+        return 1;
+      BandAt(a, w, i, i)=d;
+      }
+    return 0;
+  }
+
+  /** @brief Solve A*x=b from the factorization
+   *
+   * @param a the factorization of BandLDLTFactor
+   * @param n the size
+   * @param w the half bandwidth
+   * @param x b on input, the solution on output
+   */
+  inline void BandLDLTSolve(const Double_t* a, Int_t n, Int_t w, Double_t* x)
+  {
+    // L*z=b, then D*y=z
+    for(Int_t i=0; i<n; i++){
+      for(Int_t j=std::max(0, i-w); j<i; j++)
+        x[i]-=BandAt(a, w, i, j)*x[j];
+      }
+    for(Int_t i=0; i<n; i++)
+      x[i]/=BandAt(a, w, i, i);
+    // L^T*x=y
+    for(Int_t i=n-1; i>=0; i--){
+      for(Int_t k=i+1; k<=std::min(n-1, i+w); k++)
+        x[i]-=BandAt(a, w, k, i)*x[k];
+      }
+  }
+
+}; // namespace
+
+#endif
@@ -0,0 +1,158 @@
+/** @file ChannelBuffer.hh
+ *
+ * @brief ChannelBuffer and FloatView class definitions
+ *
+ * Contiguous storage of one data product for all Lidar channels
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_CHANNELBUFFER
+#define LIDARTOOLS_CHANNELBUFFER
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#include <TArrayF.h>
+#endif
+
+#include <vector>
+
+namespace LidarTools {
+
+ /** @class FloatView
+  *
+  * @brief Non-owning, read-only view of an array of floats
+  *
+  * Returned by the Analyser getters instead of a TArrayF copy.
+  * A view is only valid as long as the Analyser that returned it is
+  * neither processing nor loading a new shot.
+  */
+  class FloatView
+  {
+
+  public:
+    /** @brief Empty view */
+    FloatView() : fArray(0), fN(0) {}
+    /** @brief View on a raw array of n floats */
+    FloatView(const Float_t* array, Int_t n) : fArray(array), fN(n) {}
+    /** @brief View on a TArrayF */
+    FloatView(const TArrayF& array) : fArray(array.GetArray()), fN(array.GetSize()) {}
+
+    /** @brief Return the number of elements */
+    Int_t GetSize() const                 {return fN;}
+    /** @brief Return a pointer to the first element */
+    const Float_t* GetArray() const       {return fArray;}
+    /** @brief Return element i, no bound check */
+    Float_t operator[](Int_t i) const     {return fArray[i];}
+    /** @brief Return element i, 0 if out of bounds */
+    Float_t At(Int_t i) const             {return (i>=0 && i<fN) ? fArray[i] : 0;}
+    /** @brief Return an owning copy, e.g. to keep results after the next shot */
+    TArrayF Copy() const                  {return TArrayF(fN, fArray);}
+
+  private:
+    /** @brief first element */
+    const Float_t* fArray;
+    /** @brief number of elements */
+    Int_t fN;
+  }; // class
+
+ /** @class ChannelBuffer
+  *
+  * @brief Structure-of-arrays buffer holding one product for all channels
+  *
+  * Channel slot k occupies [k*stride, k*stride+size[k]) of a single
+  * contiguous vector. Memory is kept between shots: Set only reallocates
+  * when a slot needs more than the current stride.
+  *
+  * @see ChannelRegistry
+  */
+  class ChannelBuffer
+  {
+
+  public:
+
+    /** @brief Constructor
+     *
+     */
+    ChannelBuffer();
+
+    /** @brief Destructor
+     *
+     */
+    virtual ~ChannelBuffer() {}
+
+    /** @brief Reserve memory for nslots channels of stride floats
+     *
+     * @param nslots number of channels
+     * @param stride maximum number of floats per channel
+     */
+    void Reserve(Int_t nslots, Int_t stride);
+
+    /** @brief Size a channel slot to n floats, all set to 0
+     *
+     * @param slot the channel slot index
+     * @param n the number of floats
+     * @return a pointer to the first float of the slot
+     */
+    Float_t* Set(Int_t slot, Int_t n);
+
+    /** @brief Size a channel slot to n floats, copied from data
+     *
+     * @param slot the channel slot index
+     * @param n the number of floats
+     * @param data the floats to copy
+     * @return a pointer to the first float of the slot
+     */
+    Float_t* Set(Int_t slot, Int_t n, const Float_t* data);
+
+    /** @brief Set all slot sizes to 0, memory is kept */
+    void Clear();
+
+    /** @brief Free memory */
+    void Release();
+
+    /** @brief Return a pointer to the first float of a slot */
+    Float_t* GetArray(Int_t slot)             {return &fData[slot*fStride];}
+    /** @brief Return a const pointer to the first float of a slot */
+    const Float_t* GetArray(Int_t slot) const {return &fData[slot*fStride];}
+
+    /** @brief Return the number of floats in a slot, 0 for unknown slots */
+    Int_t GetSize(Int_t slot) const {
+		if(slot>=0 && slot<fNSlots) return fSize[slot];
+		return 0;
+		}
+
+    /** @brief Return a view on a slot, empty for unknown slots */
+    FloatView View(Int_t slot) const {
+		if(GetSize(slot)>0) return FloatView(GetArray(slot), fSize[slot]);
+		return FloatView();
+		}
+
+    /** @brief Return the number of slots */
+    Int_t GetNSlots() const                   {return fNSlots;}
+    /** @brief Return the stride */
+    Int_t GetStride() const                   {return fStride;}
+    /** @brief Return the allocated memory in bytes */
+    Long64_t GetBytes() const                 {return fData.capacity()*sizeof(Float_t);}
+
+  private:
+    /** @brief number of channel slots */
+    Int_t fNSlots;
+    /** @brief distance between 2 slots in floats */
+    Int_t fStride;
+    /** @brief data for all slots */
+    std::vector<Float_t> fData;
+    /** @brief used size of each slot */
+    std::vector<Int_t> fSize;
+
+  protected:
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+    ClassDef(LidarTools::ChannelBuffer,1);
+#endif
+
+  }; // class
+
+}; // namespace
+
+#endif
@@ -0,0 +1,101 @@
+/** @file ChannelRegistry.hh
+ *
+ * @brief ChannelRegistry class definition
+ *
+ * Class to map Lidar wavelengths to dense channel slot indices
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_CHANNELREGISTRY
+#define LIDARTOOLS_CHANNELREGISTRY
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <vector>
+
+namespace LidarTools {
+
+ /** @class ChannelRegistry
+  *
+  * @brief Map wavelengths to slot indices 0..N-1
+  *
+  * Slots are attributed in the order wavelengths are registered and are
+  * used to index the ChannelBuffer products of the Analyser.
+  * With 2 or 3 channels a linear search is faster than a std::map.
+  *
+  * @see ChannelBuffer Analyser
+  */
+  class ChannelRegistry
+  {
+
+  public:
+
+    /** @brief Constructor
+     *
+     */
+    ChannelRegistry(Bool_t verbose=false);
+
+    /** @brief Destructor
+     *
+     */
+    virtual ~ChannelRegistry() {}
+
+    /** @brief Register a wavelength, if not yet known
+     *
+     * @param wl the wavelength as an integer
+     * @return the slot index of the wavelength
+     */
+    Int_t Register(Int_t wl);
+
+    /** @brief Forget all wavelengths */
+    void Clear()                         {fWaveLengthVec.clear();}
+
+    /** @brief Return the slot index of a wavelength, -1 if unknown
+     *
+     * @param wl the wavelength as an integer
+     */
+    Int_t GetSlot(Int_t wl) const {
+		for(UInt_t i=0; i<fWaveLengthVec.size(); i++)
+		  if(fWaveLengthVec[i]==wl) return i;
+		return -1;
+		}
+
+    /** @brief Return true if the wavelength is registered
+     *
+     * @param wl the wavelength as an integer
+     */
+    Bool_t Has(Int_t wl) const           {return GetSlot(wl)>=0;}
+
+    /** @brief Return the wavelength of a given slot
+     *
+     * @param slot the slot index
+     */
+    Int_t GetWavelength(Int_t slot) const {return fWaveLengthVec[slot];}
+
+    /** @brief Return the number of registered channels */
+    Int_t GetNChannels() const           {return fWaveLengthVec.size();}
+
+    /** @brief Return the vector of registered wavelengths, in slot order */
+    const std::vector<Int_t>& GetWavelengths() const {return fWaveLengthVec;}
+
+  private:
+    /** @brief boolean to print some results if true */
+    Bool_t fVerbose; //!
+
+    /** @brief wavelengths indexed by slot */
+    std::vector<Int_t> fWaveLengthVec;
+
+  protected:
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+    ClassDef(LidarTools::ChannelRegistry,1);
+#endif
+
+  }; // class
+
+}; // namespace
+
+#endif
@@ -16,14 +16,38 @@
 #endif
 
 #include <map>
+#include <string>
+#include <vector>
+#include <ctime>        // time_t
 #include <cstdlib>      // atof
 
+#include "IntervalIndex.hh"
+
 namespace LidarTools {
 	
 /** @class ConfigHandler
  * 
  * @brief Manage a configuration for the Analyser
  * 
+ * A configuration file may declare epochs, sections whose parameters
+ * only apply to some runs, e.g. after a realignment:
+ *
+ *     [Realigned2012]
+ *     Runs  = 70000-
+ *     Dates = 2012-03-01/2013-12-31
+ *     AlignCorr_355 = 0.05
+ *
+ * Runs is first-last, Dates first/last in UTC days, both inclusive and
+ * either side may be left open. An epoch with both applies to runs that
+ * are in both intervals. Sections without Runs nor Dates are part of the
+ * nominal configuration. When several epochs apply, the last one in the
+ * file wins.
+ *
+ * The parameters of a run are resolved in this order, each step winning
+ * over the previous ones: the nominal configuration, the epochs of the
+ * run, then the explicit overrides, Analyser::OverwriteConfigParam or the
+ * parameter sets of SweepRunner.
+ *
  * @see Analyser
  * 
 */
@@ -51,13 +75,60 @@ namespace LidarTools {
 
     /** @brief Reset the configuration to default values
      *
+     * The data files are in GetSoftRoot()/LidarTools/data
     */
     void Reset();
 
+    /** @brief Return HESSUSER if set, else HESSROOT, else the current directory
+     *
+     * @return std::string
+    */
+    static std::string GetSoftRoot();
+
     /** @brief Read a configuration from an ascii file
-     *  and store it in the configuration map
+     *  and store it in the configuration map, and its epochs
     */
     void Read(std::string);
+
+    /** @brief Declare an epoch
+     *
+     * @param name the epoch name
+     * @param runs the run interval, first-last, empty for all runs
+     * @param dates the date interval, YYYY-MM-DD/YYYY-MM-DD, empty for all dates
+     * @return the epoch index, -1 if an interval can not be parsed
+    */
+    Int_t AddEpoch(std::string name, std::string runs, std::string dates);
+
+    /** @brief Set a parameter of an epoch
+     *
+     * @param epoch the epoch index
+     * @param key the parameter name as a string
+     * @param value the parameter value as a string
+    */
+    void SetEpochParam(Int_t epoch, std::string key, std::string value);
+
+    /** @brief Remove all epochs */
+    void ClearEpochs();
+
+    /** @brief Returns the number of epochs */
+    Int_t GetNEpochs() const {return fEpochs.size();}
+
+    /** @brief Returns the name of an epoch */
+    std::string GetEpochName(Int_t epoch) const {return fEpochs[epoch].fName;}
+
+    /** @brief Epochs that apply to a run, in O(log n) for n epochs
+     *
+     * @param run the run number
+     * @param time the time of the run
+     * @param epochs the epoch indices, in the order of the file
+    */
+    void FindEpochs(Int_t run, time_t time, std::vector<Int_t>& epochs) const;
+
+    /** @brief Set the parameters of some epochs, in the given order
+     *
+     * @param epochs the epoch indices, as from FindEpochs
+    */
+    void ApplyEpochs(const std::vector<Int_t>& epochs);
     
     /** @brief Write the configuration map to an ascii file
      *  
@@ -97,6 +168,23 @@ namespace LidarTools {
      * @return Int_t
     */
     Int_t GetParamI(std::string key)    {return atoi(GetParam(key).c_str());}
+
+    /** @brief Get a float parameter for a given wavelength, e.g. R0_355
+     *
+     * @param prefix the parameter name without the wavelength, e.g. "R0_"
+     * @param wl the wave length
+     * @param def value returned if the parameter is not defined
+     * @return Float_t
+    */
+    Float_t GetChannelParamF(std::string prefix, Int_t wl, Float_t def) const;
+
+    /** @brief Set a float parameter for a given wavelength, e.g. R0_355
+     *
+     * @param prefix the parameter name without the wavelength, e.g. "R0_"
+     * @param wl the wave length
+     * @param value the parameter value
+    */
+    void SetChannelParamF(std::string prefix, Int_t wl, Float_t value);
     
     /** @brief Set a parameter of the current configuration
      *  
@@ -177,6 +265,19 @@ namespace LidarTools {
     Bool_t  GetParamLogBins()          {if (GetParamI("LogBins")>0) return true;
 		                                else return false;}
 
+   /** @brief Returns true if adaptive binning is chosen in the current configuration
+    *  
+    * @return Bool_t
+    */
+    Bool_t  GetParamAdaptiveBins()     {if (GetParamI("AdaptiveBins")>0) return true;
+		                                else return false;}
+
+   /** @brief Returns the target S/N of the adaptive bins
+    *  
+    * @return Float_t
+    */
+    Float_t GetParamAdaptiveBinsSNR()  {return GetParamF("AdaptiveBinsSNR");}
+
    /** @brief Returns true if logartihmic binning is chosen in the current configuration
     *  
     * @return Int_t
@@ -196,22 +297,14 @@ namespace LidarTools {
     *  
     * @return Float_t
     */
-    Float_t GetParamR0(Int_t wl)             {
-		if (wl==355)        return GetParamF("R0_355");
-		else if (wl==532)  return GetParamF("R0_532");
-		else               return 0;
-		 }
+    Float_t GetParamR0(Int_t wl)             {return GetChannelParamF("R0_", wl, 0);}
 
    /** @brief Returns the Fernald Sp factor in the current configuration
     *  for a given wave length
     *  
     * @return Float_t
     */
-    Float_t GetParamFernaldSp(Int_t wl)             {
-		if (wl==355)        return GetParamF("Fernald_Sp355");
-		else if (wl==532)   return GetParamF("Fernald_Sp532");
-		else               return 0;
-		 }
+    Float_t GetParamFernaldSp(Int_t wl)             {return GetFernald_Sp(wl);}
 
    /** @brief Returns true if alignment correction factor optimization
     * is requested in the current configuration
@@ -233,11 +326,7 @@ namespace LidarTools {
     *  
     * @return Float_t
     */
-    Float_t GetParamAC(Int_t wl)             {
-		if (wl==355)        return GetParamF("AlignCorr_355");
-		else if (wl==532)  return GetParamF("AlignCorr_532");
-		else               return 0;
-		 }
+    Float_t GetParamAC(Int_t wl)             {return GetChannelParamF("AlignCorr_", wl, 0);}
 
    /** @brief Returns the Klett inverstion k parameter
     *  as in beta=l*alpha^k
@@ -293,6 +382,13 @@ namespace LidarTools {
     */  
     std::string GetOverlap()         {return GetParam("OverlapFunction");}
 
+   /** @brief Returns the name of the file of the external AOD of each run
+    * @see AODTable
+    * 
+    * @return std::string
+    */  
+    std::string GetAODTable()        {return GetParam("AODTable");}
+
    /** @brief Return the name of the chosen inversion algorithm
     * @see Analyser::ProcessData
     *  
@@ -306,11 +402,7 @@ namespace LidarTools {
     * @param wl the wave lenght 
     * @return Float_t
     */
-    Float_t GetFernald_Sp(Int_t wl)             {
-		if (wl==355)        return GetParamF("Fernald_Sp355");
-		else if (wl==532)  return GetParamF("Fernald_Sp532");
-		else               return 0;
-		 }
+    Float_t GetFernald_Sp(Int_t wl)             {return GetChannelParamF("Fernald_Sp", wl, 50);}
 
    /** @brief Returns Fernald Sratio parameter:
     * Sratio=1+Beta_p/Beta_m
@@ -334,6 +426,259 @@ namespace LidarTools {
     */
     Float_t GetSNRatioThreshold()           {return GetParamF("SNRatioThreshold");}
 
+   /** @brief Returns the number of coarse bins of the early classification
+    * @see Analyser::Classify
+    *  
+    * @return Int_t
+    */
+    Int_t GetClassifyNCoarse()              {return GetParamI("ClassifyNCoarse");}
+
+   /** @brief Returns the minimal S/N per sample of the lowest coarse bin
+    * @see Analyser::Classify
+    *  
+    * @return Float_t
+    */
+    Float_t GetClassifyMinSNR()             {return GetParamF("ClassifyMinSNR");}
+
+   /** @brief Returns the altitude above the Lidar in m below which the signal
+    *  of a coarse bin may not be lost, 0 for the lowest coarse bin only
+    * @see Analyser::Classify
+    *  
+    * @return Float_t
+    */
+    Float_t GetClassifyMinSignalAlt()       {return GetParamF("ClassifyMinSignalAlt");}
+
+   /** @brief Returns the maximal background drift in %, 0 to disable
+    * @see Analyser::Classify
+    *  
+    * @return Float_t
+    */
+    Float_t GetClassifyBkgDriftMax()        {return GetParamF("ClassifyBkgDriftMax");}
+
+   /** @brief Returns the maximal background RMS in V, 0 to disable
+    * @see Analyser::Classify
+    *  
+    * @return Float_t
+    */
+    Float_t GetClassifyBkgRMSMax()          {return GetParamF("ClassifyBkgRMSMax");}
+
+   /** @brief Returns the number of consecutive samples at the trace minimum
+    *  that make a shot clipped, 0 to disable
+    * @see Analyser::PreScan
+    *  
+    * @return Int_t
+    */
+    Int_t GetClassifyClipRun()              {return GetParamI("ClassifyClipRun");}
+
+
+   /** @brief Returns the reasons that reject a shot, bits of ShotClass::Reason
+    * @see Analyser::Classify
+    *  
+    * @return UInt_t
+    */
+    UInt_t GetClassifyRejectMask()          {return GetParamI("ClassifyRejectMask");}
+
+   /** @brief Returns the half width in samples of the layer derivative window
+    * @see Analyser::DetectLayers
+    *  
+    * @return Int_t
+    */
+    Int_t GetLayerHalfWidth()               {return GetParamI("LayerHalfWidth");}
+
+   /** @brief Returns the threshold on the derivative of ln(power) per km
+    * @see Analyser::DetectLayers
+    *  
+    * @return Float_t
+    */
+    Float_t GetLayerThreshold()             {return GetParamF("LayerThreshold");}
+
+   /** @brief Returns the minimal mean S/N per sample to look for layers
+    * @see Analyser::DetectLayers
+    *  
+    * @return Float_t
+    */
+    Float_t GetLayerMinSNR()                {return GetParamF("LayerMinSNR");}
+
+   /** @brief Returns the minimal increase of ln(power) of a layer
+    * @see Analyser::DetectLayers
+    *  
+    * @return Float_t
+    */
+    Float_t GetLayerMinStrength()           {return GetParamF("LayerMinStrength");}
+
+   /** @brief Returns true if R0 has to be moved below the lowest layer
+    * @see Analyser::DetectLayers
+    *  
+    * @return Bool_t
+    */
+    Bool_t GetParamR0BelowLayers()          {if (GetParamI("R0BelowLayers")>0) return true;
+		                                else return false;}
+
+   /** @brief Returns the number of Monte Carlo replicas, 0 if disabled
+    * @see Analyser::RunEnsemble
+    *  
+    * @return Int_t
+    */
+    Int_t GetEnsembleSize()                 {return GetParamI("EnsembleSize");}
+
+   /** @brief Returns the seed of the replicas random streams
+    * @see Analyser::RunEnsemble
+    *  
+    * @return Int_t
+    */
+    Int_t GetEnsembleSeed()                 {return GetParamI("EnsembleSeed");}
+
+   /** @brief Returns the number of threads of the ensemble, 0 for all
+    * @see Analyser::RunEnsemble
+    *  
+    * @return Int_t
+    */
+    Int_t GetEnsembleThreads()              {return GetParamI("EnsembleThreads");}
+
+   /** @brief Returns the prior width of the particle lidar ratio, in sr
+    * @see Analyser::RunEnsemble
+    *  
+    * @return Float_t
+    */
+    Float_t GetEnsembleSpSigma()            {return GetParamF("EnsembleSpSigma");}
+
+   /** @brief Returns the prior width of the scattering ratio at R0
+    * @see Analyser::RunEnsemble
+    *  
+    * @return Float_t
+    */
+    Float_t GetEnsembleSratioSigma()        {return GetParamF("EnsembleSratioSigma");}
+
+   /** @brief Returns the prior width of the reference altitude, in m
+    * @see Analyser::RunEnsemble
+    *  
+    * @return Float_t
+    */
+    Float_t GetEnsembleR0Sigma()            {return GetParamF("EnsembleR0Sigma");}
+
+   /** @brief Returns the prior width of the background fudge factor
+    * @see Analyser::RunEnsemble
+    *  
+    * @return Float_t
+    */
+    Float_t GetEnsembleBkgFFactorSigma()    {return GetParamF("EnsembleBkgFFactorSigma");}
+
+   /** @brief Returns true if the binned power errors are propagated
+    *  through the inversions
+    * @see Analyser::Invert
+    *  
+    * @return Bool_t
+    */
+    Bool_t GetParamPropagateErrors()        {if (GetParamI("PropagateErrors")>0) return true;
+		                                else return false;}
+
+   /** @brief Returns true if the derivatives of the optical depths
+    *  are computed
+    * @see Analyser::ComputeSensitivities
+    *  
+    * @return Bool_t
+    */
+    Bool_t GetParamSensitivities()          {if (GetParamI("Sensitivities")>0) return true;
+		                                else return false;}
+
+   /** @brief Returns true if Sp is retrieved from the external AOD of the run
+    * @see Analyser::SolveSp
+    *  
+    * @return Bool_t
+    */
+    Bool_t GetParamSpSolve()                {if (GetParamI("SpSolve")>0) return true;
+		                                else return false;}
+
+   /** @brief Returns the tolerance on the retrieved Sp, in sr
+    * @see Analyser::SolveSp
+    *  
+    * @return Float_t
+    */
+    Float_t GetParamSpSolveTolerance()      {return GetParamF("SpSolveTolerance");}
+
+   /** @brief Returns the maximal number of iterations of the Sp retrieval
+    * @see Analyser::SolveSp
+    *  
+    * @return Int_t
+    */
+    Int_t GetParamSpSolveMaxIter()          {return GetParamI("SpSolveMaxIter");}
+
+   /** @brief Returns the lower end of the Sp range of the retrieval, in sr
+    * @see Analyser::SolveSp
+    *  
+    * @return Float_t
+    */
+    Float_t GetParamSpSolveMin()            {return GetParamF("SpSolveMin");}
+
+   /** @brief Returns the upper end of the Sp range of the retrieval, in sr
+    * @see Analyser::SolveSp
+    *  
+    * @return Float_t
+    */
+    Float_t GetParamSpSolveMax()            {return GetParamF("SpSolveMax");}
+
+   /** @brief Returns the largest time between the run and the external
+    *  AOD observation, in hours
+    * @see AODTable::GetAOD
+    *  
+    * @return Float_t
+    */
+    Float_t GetParamSpSolveMaxHours()       {return GetParamF("SpSolveMaxHours");}
+
+   /** @brief Returns true if two channels are inverted jointly
+    * @see Analyser::InvertJoint
+    *  
+    * @return Bool_t
+    */
+    Bool_t GetParamJointInversion()         {if (GetParamI("JointInversion")>0) return true;
+		                                else return false;}
+
+   /** @brief Returns the first wavelength of the joint inversion
+    * @see Analyser::InvertJoint
+    *  
+    * @return Int_t
+    */
+    Int_t GetParamJointWl1()                {return GetParamI("JointWl1");}
+
+   /** @brief Returns the second wavelength of the joint inversion
+    * @see Analyser::InvertJoint
+    *  
+    * @return Int_t
+    */
+    Int_t GetParamJointWl2()                {return GetParamI("JointWl2");}
+
+   /** @brief Returns the weight of the second differences of the
+    *  OptimalEstimation inversion
+    * @see OptimalEstimationAlgorithm
+    *  
+    * @return Float_t
+    */
+    Float_t GetParamOESmoothing()           {return GetParamF("OESmoothing");}
+
+   /** @brief Returns the prior width of beta_p/beta_m of the
+    *  OptimalEstimation inversion
+    * @see OptimalEstimationAlgorithm
+    *  
+    * @return Float_t
+    */
+    Float_t GetParamOEPriorSigma()          {return GetParamF("OEPriorSigma");}
+
+   /** @brief Returns the maximal number of iterations of the
+    *  OptimalEstimation inversion
+    * @see OptimalEstimationAlgorithm
+    *  
+    * @return Int_t
+    */
+    Int_t GetParamOEMaxIter()               {return GetParamI("OEMaxIter");}
+
+   /** @brief Returns the convergence tolerance on beta_p/beta_m of the
+    *  OptimalEstimation inversion
+    * @see OptimalEstimationAlgorithm
+    *  
+    * @return Float_t
+    */
+    Float_t GetParamOETolerance()           {return GetParamF("OETolerance");}
+
    /** @brief Returns the config map
     * 
     * @see Plotter::SaveAs
@@ -351,6 +696,30 @@ namespace LidarTools {
     * 
     */  
     std::map <std::string, std::string> fConfig;
+
+    /** @brief Parameters that only apply to a run or date interval */
+    struct Epoch
+    {
+      /** @brief Section name */
+      std::string fName;
+      /** @brief A run interval is declared */
+      Bool_t fHasRuns;
+      /** @brief A date interval is declared */
+      Bool_t fHasDates;
+      /** @brief Run interval */
+      Long64_t fRuns[2];
+      /** @brief Date interval, in seconds since 1970 */
+      Long64_t fDates[2];
+      /** @brief The <key,value> map of the epoch */
+      std::map <std::string, std::string> fConfig;
+    };
+
+    /** @brief Epochs, in the order of the file */
+    std::vector<Epoch> fEpochs; //!
+    /** @brief Epochs by run interval */
+    IntervalIndex fRunIndex; //!
+    /** @brief Epochs by date interval, of those without run interval */
+    IntervalIndex fDateIndex; //!
            
   protected:
     
@@ -0,0 +1,141 @@
+/** @file Dual.hh
+ *
+ * @brief Dual numbers for forward mode automatic differentiation
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_DUAL
+#define LIDARTOOLS_DUAL
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <cmath>
+
+namespace LidarTools {
+
+ /** @class Dual
+  *
+  * @brief A value and its derivatives with respect to N parameters
+  *
+  * Code templated on its scalar type runs on Dual<N> as on Float_t or
+  * Double_t, and gives the derivatives of its results in the same pass:
+  * each operation applies the chain rule to the N derivatives.
+  * Parameter k is seeded with Variable(value, k), all other inputs are
+  * constants. Comparisons only look at the value.
+  */
+  template <Int_t N>
+  class Dual
+  {
+
+  public:
+    /** @brief Constructor, a constant
+     *
+     * @param value the value
+     */
+    Dual(Double_t value=0.) : fValue(value) {
+		for(Int_t k=0; k<N; k++) fDeriv[k]=0.;
+		}
+
+    /** @brief Return parameter k, its derivative with respect to itself is 1
+     *
+     * @param value the value of the parameter
+     * @param k the parameter index
+     */
+    static Dual Variable(Double_t value, Int_t k) {
+		Dual x(value);
+		x.fDeriv[k]=1.;
+		return x;
+		}
+
+    /** @brief Return the value */
+    Double_t GetValue() const                 {return fValue;}
+    /** @brief Return the derivative with respect to parameter k */
+    Double_t GetDerivative(Int_t k) const     {return fDeriv[k];}
+    /** @brief Set the derivative with respect to parameter k */
+    void SetDerivative(Int_t k, Double_t d)   {fDeriv[k]=d;}
+
+    // Arithmetic, with the chain rule on the derivatives
+    Dual& operator+=(const Dual& b) {
+		fValue+=b.fValue;
+		for(Int_t k=0; k<N; k++) fDeriv[k]+=b.fDeriv[k];
+		return *this;
+		}
+    Dual& operator-=(const Dual& b) {
+		fValue-=b.fValue;
+		for(Int_t k=0; k<N; k++) fDeriv[k]-=b.fDeriv[k];
+		return *this;
+		}
+    Dual& operator*=(const Dual& b) {
+		for(Int_t k=0; k<N; k++) fDeriv[k]=fDeriv[k]*b.fValue+fValue*b.fDeriv[k];
+		fValue*=b.fValue;
+		return *this;
+		}
+    Dual& operator/=(const Dual& b) {
+		Double_t inv=1./b.fValue;
+		fValue*=inv;
+		for(Int_t k=0; k<N; k++) fDeriv[k]=(fDeriv[k]-fValue*b.fDeriv[k])*inv;
+		return *this;
+		}
+    Dual operator-() const {
+		Dual x(*this);
+		x.fValue=-fValue;
+		for(Int_t k=0; k<N; k++) x.fDeriv[k]=-fDeriv[k];
+		return x;
+		}
+
+    /** @brief Return f(x) from f(value) and f'(value) */
+    Dual Apply(Double_t f, Double_t df) const {
+		Dual x(f);
+		for(Int_t k=0; k<N; k++) x.fDeriv[k]=df*fDeriv[k];
+		return x;
+		}
+
+    // Math functions, found by argument dependent lookup only, so that
+    // they do not hide the ones of cmath in the namespace
+    friend Dual exp(const Dual& x) {
+		Double_t e=std::exp(x.fValue);
+		return x.Apply(e, e);
+		}
+    friend Dual log(const Dual& x) {
+		return x.Apply(std::log(x.fValue), 1./x.fValue);
+		}
+    friend Dual sqrt(const Dual& x) {
+		Double_t s=std::sqrt(x.fValue);
+		return x.Apply(s, 0.5/s);
+		}
+    friend Dual fabs(const Dual& x) {
+		return x.fValue<0 ? -x : x;
+		}
+    friend Dual pow(const Dual& x, Double_t p) {
+		return x.Apply(std::pow(x.fValue, p), p*std::pow(x.fValue, p-1.));
+		}
+
+  private:
+    /** @brief Value */
+    Double_t fValue;
+    /** @brief Derivatives with respect to each parameter */
+    Double_t fDeriv[N];
+  }; // class
+
+  // Arithmetic with constants
+  template <Int_t N> inline Dual<N> operator+(Dual<N> a, const Dual<N>& b) {return a+=b;}
+  template <Int_t N> inline Dual<N> operator-(Dual<N> a, const Dual<N>& b) {return a-=b;}
+  template <Int_t N> inline Dual<N> operator*(Dual<N> a, const Dual<N>& b) {return a*=b;}
+  template <Int_t N> inline Dual<N> operator/(Dual<N> a, const Dual<N>& b) {return a/=b;}
+  template <Int_t N> inline Dual<N> operator+(Dual<N> a, Double_t b) {return a+=Dual<N>(b);}
+  template <Int_t N> inline Dual<N> operator-(Dual<N> a, Double_t b) {return a-=Dual<N>(b);}
+  template <Int_t N> inline Dual<N> operator*(Dual<N> a, Double_t b) {return a*=Dual<N>(b);}
+  template <Int_t N> inline Dual<N> operator/(Dual<N> a, Double_t b) {return a*=Dual<N>(1./b);}
+  template <Int_t N> inline Dual<N> operator+(Double_t a, const Dual<N>& b) {return Dual<N>(a)+=b;}
+  template <Int_t N> inline Dual<N> operator-(Double_t a, const Dual<N>& b) {return Dual<N>(a)-=b;}
+  template <Int_t N> inline Dual<N> operator*(Double_t a, const Dual<N>& b) {return Dual<N>(a)*=b;}
+  template <Int_t N> inline Dual<N> operator/(Double_t a, const Dual<N>& b) {return Dual<N>(a)/=b;}
+  template <Int_t N> inline Bool_t operator<(const Dual<N>& a, const Dual<N>& b) {return a.GetValue()<b.GetValue();}
+  template <Int_t N> inline Bool_t operator>(const Dual<N>& a, const Dual<N>& b) {return a.GetValue()>b.GetValue();}
+
+}; // namespace
+
+#endif
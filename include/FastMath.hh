@@ -0,0 +1,85 @@
+/** @file FastMath.hh
+ *
+ * @brief Inline math functions without library calls, so that the loops
+ *  over them vectorize
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_FASTMATH
+#define LIDARTOOLS_FASTMATH
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <cstring>
+
+namespace LidarTools {
+
+  /** @brief exp(x) in double precision
+   *
+   *  x=n*ln2+r with |r|<=ln2/2, exp(r) from its Taylor series to r^11
+   *  and 2^n built in the exponent bits. The relative error is below 1e-14,
+   *  so that the result rounded to a float is the one of exp.
+   *  |x| is clamped to 708, in the range of normal doubles, NaN is kept.
+   *  The clamp compares the high 32 bits as integers: a floating point
+   *  compare may trap, and SSE2 has no 64 bit compare, so the compiler
+   *  would not vectorize either.
+   *
+   * @param x the argument
+   */
+  inline Double_t FastExp(Double_t x)
+  {
+    const Double_t kLog2e=1.4426950408889634;
+    const Double_t kLn2Hi=6.93147180369123816490e-01;
+    const Double_t kLn2Lo=1.90821492927058770002e-10;
+    // 1.5*2^52, adding it rounds to the nearest integer
+    const Double_t kShift=6755399441055744.;
+    const Int_t kMaxHigh=0x40862000; // 708.
+    const Int_t kInfHigh=0x7FF00000;
+    ULong64_t xbits;
+    std::memcpy(&xbits, &x, sizeof(xbits));
+    ULong64_t sign=xbits&0x8000000000000000ULL;
+    Int_t high=(Int_t)((xbits>>32)&0x7FFFFFFF);
+    xbits=(high>kMaxHigh && high<=kInfHigh) ? (sign|((ULong64_t)kMaxHigh<<32)) : xbits;
+    std::memcpy(&x, &xbits, sizeof(x));
+    Double_t kn=x*kLog2e+kShift;
+    Double_t n=kn-kShift;
+    Double_t r=x-n*kLn2Hi-n*kLn2Lo;
+    Double_t p=1./39916800.;
+    p=p*r+1./3628800.;
+    p=p*r+1./362880.;
+    p=p*r+1./40320.;
+    p=p*r+1./5040.;
+    p=p*r+1./720.;
+    p=p*r+1./120.;
+    p=p*r+1./24.;
+    p=p*r+1./6.;
+    p=p*r+0.5;
+    p=p*r+1.;
+    p=p*r+1.;
+    // n is in the low bits of kn
+    ULong64_t bits;
+    std::memcpy(&bits, &kn, sizeof(bits));
+    bits=(bits+1023)<<52;
+    Double_t scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p*scale;
+  }
+
+  /** @brief y[i]=exp(-x[i]) for n floats, see FastExp
+   *
+   * @param x the arguments
+   * @param y the results, may be x
+   * @param n the number of values
+   */
+  inline void FastExpMinus(const Float_t* x, Float_t* y, Int_t n)
+  {
+    for(Int_t i=0; i<n; i++)
+      y[i]=FastExp(-(Double_t)x[i]);
+  }
+
+}; // namespace
+
+#endif
@@ -0,0 +1,144 @@
+/** @file FernaldBatch.hh
+ *
+ * @brief Fernald 1984 inversion of many profiles on the same altitude grid
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_FERNALDBATCH
+#define LIDARTOOLS_FERNALDBATCH
+
+#include <cmath>
+
+#include "Inversion.hh"
+#include "FastMath.hh"
+
+namespace LidarTools {
+
+ /** @brief Inputs of the batched Fernald84 inversion
+  *
+  * fLanes independent profiles, e.g. wavelengths, Sp or AlignCorr values,
+  * replicas, on the same altitude grid. Values of all lanes for bin i are
+  * contiguous, at i*fLanes+lane, and so are the outputs.
+  */
+  struct FernaldBatchInput {
+    /** @brief number of bins up to the reference bin */
+    Int_t fN;
+    /** @brief number of profiles */
+    Int_t fLanes;
+    /** @brief altitude of each slab, fN values, shared by all lanes */
+    const Float_t* fAltitude;
+    /** @brief thickness of each slab, fN-1 values, shared by all lanes */
+    const Float_t* fThickness;
+    /** @brief Lidar altitude above sea level, in m */
+    Float_t fLidarAltitude;
+    /** @brief binned power, fN*fLanes values */
+    const Float_t* fBinPw;
+    /** @brief molecular extinction, fN*fLanes values */
+    const Float_t* fAlphaMol;
+    /** @brief Lidar ratio of particles, fLanes values */
+    const Float_t* fSp;
+    /** @brief scattering ratio at the reference, fLanes values */
+    const Float_t* fSratio;
+    /** @brief mis-alignment correction factor, fLanes values */
+    const Float_t* fAlignCorr;
+  };
+
+  /** @brief Number of lanes stepped together, 8 floats fill an AVX register */
+  const Int_t kFernaldBatchWidth=8;
+
+  /** @brief Fernald84 step of bin i for W lanes from l0
+   *
+   *  Inputs are copied to local arrays first, so that the loops over the
+   *  W lanes have no aliasing and vectorize. W=1 is the scalar tail.
+   */
+  template <Int_t W>
+  inline void FernaldBatchStep(const FernaldBatchInput& in, InversionOutput& out,
+                               Int_t i, Int_t l0, Double_t corr, Float_t thickness)
+  {
+    const Float_t Sr=8.*3.14159/3.;
+    Int_t lanes=in.fLanes;
+    Int_t at=i*lanes+l0;
+    Int_t up=at+lanes;
+    Float_t sp[W], alcorr[W], pwraw[W], am[W], bm_up[W], b_up[W], pw_up[W];
+    for(Int_t k=0; k<W; k++){
+      sp[k]=in.fSp[l0+k];
+      alcorr[k]=in.fAlignCorr[l0+k];
+      pwraw[k]=in.fBinPw[at+k];
+      am[k]=in.fAlphaMol[at+k];
+      bm_up[k]=out.fBeta_M[up+k];
+      b_up[k]=out.fBeta[up+k];
+      pw_up[k]=out.fScratch[l0+k];
+      }
+    Float_t bm[W], b[W], pw[W];
+    for(Int_t k=0; k<W; k++){
+      bm[k]=am[k]/Sr;
+      // A an intermediate integral
+      Float_t A=(sp[k]-Sr)*(bm[k]+bm_up[k])*thickness;
+      Double_t expA=FastExp(A);
+      // Tweak signal for mis-alignment
+      pw[k]=pwraw[k]*(1+alcorr[k]*corr);
+      // final total backscatter formula
+      Float_t num=pw[k]*expA;
+      Float_t denom_1=pw_up[k]/b_up[k];
+      Float_t denom_2=sp[k]*(pw_up[k]+pw[k]*expA)*thickness;
+      b[k]=num/(denom_1+denom_2);
+      }
+    for(Int_t k=0; k<W; k++){
+      // Derive extinction and backscatter for particles, and total extinction
+      Float_t bp=b[k]-bm[k];
+      Float_t ap=sp[k]*bp;
+      out.fAlpha_M[at+k]=am[k];
+      out.fBeta_M[at+k]=bm[k];
+      out.fBeta[at+k]=b[k];
+      out.fBeta_P[at+k]=bp;
+      out.fAlpha_P[at+k]=ap;
+      out.fAlpha[at+k]=am[k]+ap;
+      out.fScratch[l0+k]=pw[k];
+      }
+  }
+
+  /** @brief Fernald84 inversion of fLanes profiles in lockstep
+   *
+   *  Same recurrence as Fernald84Algorithm, bin by bin from the reference
+   *  downward, kFernaldBatchWidth lanes at a time and a scalar tail.
+   *  Outputs are fN*fLanes values with the lanes of a bin contiguous,
+   *  fScratch holds fLanes floats, fAlpha0 is not set.
+   *
+   * @param in the inputs
+   * @param out the outputs
+   */
+  inline void Fernald84Lanes(const FernaldBatchInput& in, InversionOutput& out)
+  {
+    const Float_t Sr=8.*3.14159/3.;
+    Int_t n=in.fN;
+    Int_t lanes=in.fLanes;
+    // Reference values, pure Rayleigh, the power at the reference is not corrected
+    Int_t ref=(n-1)*lanes;
+    for(Int_t l=0; l<lanes; l++){
+      Float_t alpha0=in.fAlphaMol[ref+l];
+      out.fAlpha_M[ref+l]=alpha0;
+      out.fBeta_M[ref+l] =alpha0/Sr;
+      out.fBeta_P[ref+l] =out.fBeta_M[ref+l]*(in.fSratio[l]-1);
+      out.fAlpha_P[ref+l]=out.fBeta_P[ref+l]*in.fSp[l];
+      out.fAlpha[ref+l]  =out.fAlpha_M[ref+l]+out.fAlpha_P[ref+l];
+      out.fBeta[ref+l]   =out.fBeta_M[ref+l]+out.fBeta_P[ref+l];
+      out.fScratch[l]=in.fBinPw[ref+l];
+      }
+    // Inversion
+    for(Int_t i=n-2; i>=0; i--){
+      // mis-alignment correction depends on the altitude only
+      Double_t distance=10000.-in.fLidarAltitude-in.fAltitude[i];
+      Double_t corr=sqrt(std::fabs(distance)/1000.);
+      Float_t thickness=in.fThickness[i];
+      Int_t l=0;
+      for(; l+kFernaldBatchWidth<=lanes; l+=kFernaldBatchWidth)
+        FernaldBatchStep<kFernaldBatchWidth>(in, out, i, l, corr, thickness);
+      for(; l<lanes; l++)
+        FernaldBatchStep<1>(in, out, i, l, corr, thickness);
+      }
+  }
+
+}; // namespace
+
+#endif
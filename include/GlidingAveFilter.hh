@@ -56,9 +56,9 @@ namespace LidarTools {
     
     // Get Output
     /** @brief Return the vector of mean values */
-    std::vector<float> GetMeanVec()     {return fMeanVec;} 
+    const std::vector<float>& GetMeanVec() const   {return fMeanVec;} 
     /** @brief Return the vector of mean values */
-    std::vector<float> GetStdDevVec()   {return fStdDevVec;} 
+    const std::vector<float>& GetStdDevVec() const {return fStdDevVec;} 
 
     // Simple getters and setters    
     /** @brief Return the mean */
@@ -0,0 +1,97 @@
+/** @file IntervalIndex.hh
+ *
+ * @brief IntervalIndex class definition
+ *
+ * Stabbing queries on a set of closed intervals
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_INTERVALINDEX
+#define LIDARTOOLS_INTERVALINDEX
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <vector>
+
+namespace LidarTools {
+
+ /** @class IntervalIndex
+  *
+  * @brief All the intervals that contain a value, in O(log n)
+  *
+  * Build cuts the axis into segments at every interval end, and stores for
+  * each segment the identifiers of the intervals that cover it. A look up
+  * is then a binary search among the segment starts. Intervals may overlap
+  * and may be open on either side.
+  *
+  * @see ConfigHandler::FindEpochs
+  */
+  class IntervalIndex
+  {
+
+  public:
+
+    /** @brief Constructor */
+    IntervalIndex() {}
+
+    /** @brief Destructor */
+    virtual ~IntervalIndex() {}
+
+    /** @brief Remove all intervals */
+    void Clear();
+
+    /** @brief Add the closed interval [first,last]
+     *
+     * Use kMin or kMax for an open side. Build has to be called before
+     * the next Find.
+     *
+     * @param first the first value
+     * @param last the last value
+     * @param id the identifier returned by Find
+     */
+    void Add(Long64_t first, Long64_t last, Int_t id);
+
+    /** @brief Build the segments, O(n^2) for n intervals */
+    void Build();
+
+    /** @brief Identifiers of the intervals that contain a value
+     *
+     * @param x the value
+     * @param ids the identifiers, in increasing order
+     */
+    void Find(Long64_t x, std::vector<Int_t>& ids) const;
+
+    /** @brief Returns the number of intervals */
+    Int_t GetNIntervals() const {return fIntervals.size();}
+
+    /** @brief Smallest value, for an interval open on the left */
+    static const Long64_t kMin;
+    /** @brief Largest value, for an interval open on the right */
+    static const Long64_t kMax;
+
+  private:
+    /** @brief A closed interval and its identifier */
+    struct Interval
+    {
+      Long64_t fFirst;
+      Long64_t fLast;
+      Int_t    fId;
+    };
+
+    /** @brief Intervals, in the order they were added */
+    std::vector<Interval> fIntervals;
+    /** @brief First value of each segment, increasing */
+    std::vector<Long64_t> fStarts;
+    /** @brief Offset of the identifiers of each segment in fIds, one more than segments */
+    std::vector<UInt_t> fOffsets;
+    /** @brief Identifiers of the intervals covering each segment */
+    std::vector<Int_t> fIds;
+
+  }; // class
+
+}; // namespace
+
+#endif
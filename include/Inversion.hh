@@ -0,0 +1,333 @@
+/** @file Inversion.hh
+ *
+ * @brief Inversion interface, contract and registry
+ *
+ * Common contract of the Lidar inversion algorithms, and the registry
+ * resolving an algorithm name once per configuration
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_INVERSION
+#define LIDARTOOLS_INVERSION
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "KlettKernel.hh"
+#include "Dual.hh"
+
+namespace LidarTools {
+
+ /** @brief Inputs of an inversion, filled by the Analyser
+  *
+  * Index fN-1 is the reference bin, at R0. Below, index i is the slab
+  * between the bin centers i and i+1. Altitudes are in m above the Lidar.
+  * Errors are propagated only when fBinPwErr is set, and the output has fAlphaErr.
+  */
+  struct InversionInput {
+    /** @brief Constructor, all 0 */
+    InversionInput()
+      : fWavelength(0), fN(0), fBinPw(0), fAltitude(0), fThickness(0), fAlphaMol(0),
+        fAlphaModel(0), fLidarAltitude(0), fSp(0), fSratio(0), fAlignCorr(0),
+        fKlett_k(1), fKlett_l(1), fKlettKernel(0), fBinPwErr(0), fODWeight(0),
+        fOESmoothing(1.), fOEPriorSigma(10.), fOEMaxIter(20), fOETolerance(1.e-4) {}
+    /** @brief wavelength as an integer */
+    Int_t fWavelength;
+    /** @brief number of bins up to the reference bin */
+    Int_t fN;
+    /** @brief binned power, fN values */
+    const Float_t* fBinPw;
+    /** @brief altitude of each slab, and of the reference at fN-1 */
+    const Float_t* fAltitude;
+    /** @brief thickness of each slab along the line of sight, fN-1 values */
+    const Float_t* fThickness;
+    /** @brief molecular extinction from the atmosphere profile, fN values */
+    const Float_t* fAlphaMol;
+    /** @brief total extinction from the absorption model, fN values */
+    const Float_t* fAlphaModel;
+    /** @brief Lidar altitude above sea level, in m */
+    Float_t fLidarAltitude;
+    /** @brief Lidar ratio of particles */
+    Float_t fSp;
+    /** @brief scattering ratio at the reference, 1+beta_p/beta_m */
+    Float_t fSratio;
+    /** @brief mis-alignment correction factor */
+    Float_t fAlignCorr;
+    /** @brief Klett exponent, as in beta=l*alpha^k */
+    Float_t fKlett_k;
+    /** @brief Klett factor, as in beta=l*alpha^k */
+    Float_t fKlett_l;
+    /** @brief Klett recurrence specialized for fKlett_k */
+    KlettKernel fKlettKernel;
+    /** @brief error of the binned power, fN values, may be 0 */
+    const Float_t* fBinPwErr;
+    /** @brief width of each bin in the optical depth window, 0 outside,
+     *  fN values, may be 0 */
+    const Float_t* fODWeight;
+    /** @brief OptimalEstimation weight of the second differences */
+    Float_t fOESmoothing;
+    /** @brief OptimalEstimation prior width of beta_p/beta_m */
+    Float_t fOEPriorSigma;
+    /** @brief OptimalEstimation maximal number of Gauss-Newton iterations */
+    Int_t fOEMaxIter;
+    /** @brief OptimalEstimation largest step of beta_p/beta_m at convergence */
+    Float_t fOETolerance;
+  };
+
+ /** @brief Outputs of an inversion, fN values each
+  *
+  * The molecular and particle splits are only filled by algorithms
+  * with details, they are 0 otherwise. Errors are filled when the
+  * input has fBinPwErr and fAlphaErr is given, they are 0 at the reference.
+  */
+  struct InversionOutput {
+    /** @brief Constructor, all 0 */
+    InversionOutput()
+      : fAlpha(0), fBeta(0), fAlpha_M(0), fBeta_M(0), fAlpha_P(0), fBeta_P(0),
+        fScratch(0), fAlpha0(0), fAlphaErr(0), fBetaErr(0), fODErr(0), fNIter(0) {}
+    /** @brief total extinction */
+    Float_t* fAlpha;
+    /** @brief total backscatter */
+    Float_t* fBeta;
+    /** @brief molecular extinction */
+    Float_t* fAlpha_M;
+    /** @brief molecular backscatter */
+    Float_t* fBeta_M;
+    /** @brief particle extinction */
+    Float_t* fAlpha_P;
+    /** @brief particle backscatter */
+    Float_t* fBeta_P;
+    /** @brief scratch memory, GetScratchSize(fN) floats */
+    Float_t* fScratch;
+    /** @brief extinction at the reference */
+    Float_t fAlpha0;
+    /** @brief first order error of the total extinction, 0 not to propagate errors */
+    Float_t* fAlphaErr;
+    /** @brief first order error of the total backscatter */
+    Float_t* fBetaErr;
+    /** @brief first order error of the optical depth over fODWeight,
+     *  also the error of the AOD, molecules have no error */
+    Float_t fODErr;
+    /** @brief number of iterations of the iterative algorithms, 0 otherwise */
+    Int_t fNIter;
+  };
+
+ /** @brief Parameters of the sensitivities, in the order of the derivatives
+  *  of a Sensitivity scalar
+  */
+  enum SensitivityParam {kSensSp=0, kSensSratio, kSensR0, kSensAlignCorr, kSensBkgFFactor,
+                         kNSensitivities};
+
+  /** @brief Scalar of the differentiated inversions, a value and its derivatives */
+  typedef Dual<kNSensitivities> Sensitivity;
+
+ /** @brief Inputs of an inversion for any scalar type T
+  *
+  * Same contract as InversionInput, without errors. The parameters and
+  * the profiles that depend on them are of type T, the slab altitudes
+  * are not differentiated.
+  */
+  template <class T>
+  struct InversionInputOf {
+    /** @brief number of bins up to the reference bin */
+    Int_t fN;
+    /** @brief slab altitude, fN values */
+    const Float_t* fAltitude;
+    /** @brief Lidar altitude above sea level */
+    Float_t fLidarAltitude;
+    /** @brief binned power, fN values */
+    const T* fBinPw;
+    /** @brief slab thickness, fN values */
+    const T* fThickness;
+    /** @brief molecular extinction, fN values */
+    const T* fAlphaMol;
+    /** @brief model total extinction, fN values */
+    const T* fAlphaModel;
+    /** @brief particle lidar ratio */
+    T fSp;
+    /** @brief scattering ratio at the reference */
+    T fSratio;
+    /** @brief mis-alignment correction factor */
+    T fAlignCorr;
+    /** @brief Klett exponent */
+    Float_t fKlett_k;
+    /** @brief Klett factor */
+    Float_t fKlett_l;
+  };
+
+ /** @brief Outputs of an inversion for any scalar type T, allocated by the caller */
+  template <class T>
+  struct InversionOutputOf {
+    /** @brief total extinction */
+    T* fAlpha;
+    /** @brief particle extinction, only filled by algorithms with details */
+    T* fAlpha_P;
+  };
+
+ /** @class Inversion
+  *
+  * @brief Interface of an inversion algorithm
+  *
+  * Inversions are stateless, a single instance per algorithm is held
+  * by the InversionRegistry and shared by all Analysers.
+  *
+  * @see InversionOf InversionRegistry
+  */
+  class Inversion
+  {
+
+  public:
+    /** @brief Destructor */
+    virtual ~Inversion() {}
+
+    /** @brief Return the name of the algorithm, as in the AlgName parameter */
+    virtual std::string GetName() const=0;
+
+    /** @brief Return true if the molecular and particle splits are filled */
+    virtual Bool_t HasDetails() const=0;
+
+    /** @brief Return the number of scratch floats needed for n bins */
+    virtual Int_t GetScratchSize(Int_t n) const=0;
+
+    /** @brief Run the inversion
+     *
+     * @param in the inputs
+     * @param out the outputs, allocated by the caller
+     * @return 0 if OK, 1 if failed, 2 if an iterative algorithm did not
+     *         converge, the outputs of the last iteration are then usable
+     */
+    virtual int Invert(const InversionInput& in, InversionOutput& out) const=0;
+
+    /** @brief Run the inversion on dual numbers, for the derivatives of the
+     *  outputs with respect to the SensitivityParam
+     *
+     * @param in the inputs
+     * @param out the outputs, allocated by the caller
+     * @return 0 if OK, 3 if the algorithm is not differentiable
+     */
+    virtual int InvertSensitivity(const InversionInputOf<Sensitivity>&,
+                                  InversionOutputOf<Sensitivity>&) const {return 3;}
+
+    /** @brief Return true if the algorithm weights the binned power with
+     *  its errors, fBinPwErr is then always set */
+    virtual Bool_t NeedsErrors() const {return false;}
+  }; // class
+
+ /** @class InversionOf
+  *
+  * @brief Inversion for an algorithm class
+  *
+  * The algorithm provides static Name(), HasDetails(), GetScratchSize(n)
+  * and Invert(in, out). Batch code can call Algorithm::Invert directly,
+  * so that the kernel is inlined.
+  */
+  template <class Algorithm>
+  class InversionOf : public Inversion
+  {
+
+  public:
+    /** @brief Return the name of the algorithm */
+    virtual std::string GetName() const         {return Algorithm::Name();}
+    /** @brief Return true if the molecular and particle splits are filled */
+    virtual Bool_t HasDetails() const           {return Algorithm::HasDetails();}
+    /** @brief Return the number of scratch floats needed for n bins */
+    virtual Int_t GetScratchSize(Int_t n) const {return Algorithm::GetScratchSize(n);}
+    /** @brief Run the inversion */
+    virtual int Invert(const InversionInput& in, InversionOutput& out) const {
+		return Algorithm::Invert(in, out);
+		}
+  }; // class
+
+ /** @class DifferentiableInversionOf
+  *
+  * @brief Inversion for an algorithm class that also provides
+  *  template <class T> InvertGeneric(in, out), the same recurrence for
+  *  any scalar type, so that it runs on dual numbers
+  */
+  template <class Algorithm>
+  class DifferentiableInversionOf : public InversionOf<Algorithm>
+  {
+
+  public:
+    /** @brief Run the inversion on dual numbers */
+    virtual int InvertSensitivity(const InversionInputOf<Sensitivity>& in,
+                                  InversionOutputOf<Sensitivity>& out) const {
+		return Algorithm::InvertGeneric(in, out);
+		}
+  }; // class
+
+ /** @class WeightedInversionOf
+  *
+  * @brief Inversion for an algorithm class that fits the binned power
+  *  with its errors, the inputs always have fBinPwErr
+  */
+  template <class Algorithm>
+  class WeightedInversionOf : public InversionOf<Algorithm>
+  {
+
+  public:
+    /** @brief The binned power errors are needed */
+    virtual Bool_t NeedsErrors() const {return true;}
+  }; // class
+
+ /** @class InversionRegistry
+  *
+  * @brief Inversion algorithms by name
+  *
+  * Klett, Fernald84, Aeronet and OptimalEstimation are registered on first use.
+  * New algorithms are registered once, before any processing, e.g.
+  *
+  *   InversionRegistry::Instance().Register(new InversionOf<MyAlgorithm>());
+  *
+  * and are then selected with the AlgName parameter.
+  * Register is not thread safe, Get is.
+  */
+  class InversionRegistry
+  {
+
+  public:
+    /** @brief Return the registry */
+    static InversionRegistry& Instance();
+
+    /** @brief Destructor, deletes all inversions */
+    virtual ~InversionRegistry();
+
+    /** @brief Register an inversion, the registry takes ownership
+     *
+     * @param inversion the inversion
+     * @return false if an inversion of the same name is already registered,
+     *         the new one is then deleted
+     */
+    Bool_t Register(const Inversion* inversion);
+
+    /** @brief Return the inversion of a given name, 0 if unknown
+     *
+     * @param name the algorithm name
+     */
+    const Inversion* Get(const std::string& name) const;
+
+    /** @brief Return the names of all registered inversions */
+    std::vector<std::string> GetNames() const;
+
+  private:
+    /** @brief Constructor, registers the built-in algorithms */
+    InversionRegistry();
+
+    /** @brief inversions by name */
+    std::map<std::string, const Inversion*> fInversions;
+
+    // not copyable
+    InversionRegistry(const InversionRegistry&);
+    InversionRegistry& operator=(const InversionRegistry&);
+
+  }; // class
+
+}; // namespace
+
+#endif
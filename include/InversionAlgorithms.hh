@@ -0,0 +1,531 @@
+/** @file InversionAlgorithms.hh
+ *
+ * @brief Klett, Fernald84, Aeronet and OptimalEstimation inversion kernels
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_INVERSIONALGORITHMS
+#define LIDARTOOLS_INVERSIONALGORITHMS
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+#include "Inversion.hh"
+#include "FernaldBatch.hh"
+#include "RecurrenceErrors.hh"
+#include "BandSolver.hh"
+
+namespace LidarTools {
+
+ /** @brief Klett inversion, beta=l*alpha^k
+  *
+  * Initialized with the model extinction at the reference, no
+  * molecular and particle splits.
+  */
+  struct KlettAlgorithm {
+    /** @brief Name */
+    static std::string Name()                 {return "Klett";}
+    /** @brief No molecular and particle splits */
+    static Bool_t HasDetails()                {return false;}
+    /** @brief No scratch */
+    static Int_t GetScratchSize(Int_t)        {return 0;}
+
+    /** @brief Run the inversion */
+    static int Invert(const InversionInput& in, InversionOutput& out) {
+		Int_t n=in.fN;
+		out.fAlpha0=in.fAlphaModel[n-1];
+		out.fAlpha[n-1]=out.fAlpha0;
+		in.fKlettKernel(in.fKlett_k, in.fKlett_l, in.fBinPw, in.fThickness, n,
+		                out.fAlpha, out.fBeta);
+		if(in.fBinPwErr && out.fAlphaErr)
+		  PropagateErrors(in, out);
+		return 0;
+		}
+
+    /** @brief Same recurrence as KlettRecurrence, for any scalar type */
+    template <class T>
+    static int InvertGeneric(const InversionInputOf<T>& in, InversionOutputOf<T>& out) {
+		Int_t n=in.fN;
+		Double_t invk=1./in.fKlett_k;
+		T* alpha=out.fAlpha;
+		alpha[n-1]=in.fAlphaModel[n-1];
+		T root_m=pow(in.fBinPw[n-1], invk);
+		for(Int_t i=n-2; i>=0; i--){
+		  T root=pow(in.fBinPw[i], invk);
+		  alpha[i]=root/(root_m/alpha[i+1]-(root_m+root)*in.fThickness[i]);
+		  root_m=root;
+		  }
+		return 0;
+		}
+
+    /** @brief First order errors, from the outputs of the recurrence
+     *
+     * alpha=r/D with r=P^(1/k) and D=r_up/alpha_up-(r_up+r)*thickness
+     */
+    static void PropagateErrors(const InversionInput& in, InversionOutput& out) {
+		Int_t n=in.fN;
+		Double_t invk=1./in.fKlett_k;
+		const Float_t* alpha=out.fAlpha;
+		RecurrenceErrors errors;
+		// r=P^(1/k) and its error
+		Double_t r_up=pow((Double_t)in.fBinPw[n-1], invk);
+		Double_t err=invk*r_up/in.fBinPw[n-1]*in.fBinPwErr[n-1];
+		errors.Reference(err*err);
+		out.fAlphaErr[n-1]=0.;
+		out.fBetaErr[n-1]=0.;
+		// factor of r_up in the denominator of the bin below
+		Double_t K=1./alpha[n-1];
+		for(Int_t i=n-2; i>=0; i--){
+		  Double_t t=in.fThickness[i];
+		  Double_t r=pow((Double_t)in.fBinPw[i], invk);
+		  err=invk*r/in.fBinPw[i]*in.fBinPwErr[i];
+		  Double_t D=r_up/alpha[i+1]-(r_up+r)*t;
+		  Double_t w=in.fODWeight ? in.fODWeight[i] : 0.;
+		  errors.Next(1., K-t);
+		  Double_t var=errors.Bin(r, err*err, 1., -t, D, alpha[i], w);
+		  out.fAlphaErr[i]=sqrt(var);
+		  // beta=l*alpha^k
+		  out.fBetaErr[i]=std::fabs(in.fKlett_k*out.fBeta[i]/alpha[i])*out.fAlphaErr[i];
+		  K=-t;
+		  r_up=r;
+		  }
+		out.fODErr=sqrt(errors.GetVarOD());
+		}
+  };
+
+ /** @brief Fernald 1984 inversion, two components with the particle Lidar ratio Sp
+  *
+  * Initialized with the molecular extinction and the scattering ratio at
+  * the reference, the power is corrected for mis-alignment below it.
+  * Runs Fernald84Lanes with a single lane.
+  */
+  struct Fernald84Algorithm {
+    /** @brief Name */
+    static std::string Name()                 {return "Fernald84";}
+    /** @brief Molecular and particle splits */
+    static Bool_t HasDetails()                {return true;}
+    /** @brief Corrected power of the bin above */
+    static Int_t GetScratchSize(Int_t)        {return 1;}
+
+    /** @brief Run the inversion */
+    static int Invert(const InversionInput& in, InversionOutput& out) {
+		FernaldBatchInput batch;
+		batch.fN=in.fN;
+		batch.fLanes=1;
+		batch.fAltitude=in.fAltitude;
+		batch.fThickness=in.fThickness;
+		batch.fLidarAltitude=in.fLidarAltitude;
+		batch.fBinPw=in.fBinPw;
+		batch.fAlphaMol=in.fAlphaMol;
+		batch.fSp=&in.fSp;
+		batch.fSratio=&in.fSratio;
+		batch.fAlignCorr=&in.fAlignCorr;
+		Fernald84Lanes(batch, out);
+		out.fAlpha0=in.fAlphaMol[in.fN-1];
+		if(in.fBinPwErr && out.fAlphaErr)
+		  PropagateErrors(in, out);
+		return 0;
+		}
+
+    /** @brief Same recurrence as Fernald84Lanes for one profile, for any scalar type */
+    template <class T>
+    static int InvertGeneric(const InversionInputOf<T>& in, InversionOutputOf<T>& out) {
+		const Float_t Sr=8.*3.14159/3.;
+		Int_t n=in.fN;
+		const T& Sp=in.fSp;
+		// Reference values, pure Rayleigh, the power at the reference is not corrected
+		T bm_up=in.fAlphaMol[n-1]/Sr;
+		T bp_up=bm_up*(in.fSratio-1.);
+		out.fAlpha_P[n-1]=bp_up*Sp;
+		out.fAlpha[n-1]=in.fAlphaMol[n-1]+out.fAlpha_P[n-1];
+		T b_up=bm_up+bp_up;
+		T pw_up=in.fBinPw[n-1];
+		for(Int_t i=n-2; i>=0; i--){
+		  Double_t distance=10000.-in.fLidarAltitude-in.fAltitude[i];
+		  Double_t corr=sqrt(std::fabs(distance)/1000.);
+		  const T& thickness=in.fThickness[i];
+		  T bm=in.fAlphaMol[i]/Sr;
+		  T expA=exp((Sp-Sr)*(bm+bm_up)*thickness);
+		  T pw=in.fBinPw[i]*(1.+in.fAlignCorr*corr);
+		  T b=pw*expA/(pw_up/b_up+Sp*(pw_up+pw*expA)*thickness);
+		  out.fAlpha_P[i]=Sp*(b-bm);
+		  out.fAlpha[i]=in.fAlphaMol[i]+out.fAlpha_P[i];
+		  bm_up=bm;
+		  b_up=b;
+		  pw_up=pw;
+		  }
+		return 0;
+		}
+
+    /** @brief First order errors, the intermediate values of the recurrence
+     *  are computed again from its outputs as in FernaldBatchStep
+     *
+     * beta=P*exp(A)/D with D=P_up/beta_up+Sp*(P_up+P*exp(A))*thickness
+     */
+    static void PropagateErrors(const InversionInput& in, InversionOutput& out) {
+		const Float_t Sr=8.*3.14159/3.;
+		Float_t Sp=in.fSp;
+		Int_t n=in.fN;
+		RecurrenceErrors errors;
+		Double_t err=in.fBinPwErr[n-1];
+		errors.Reference(err*err);
+		out.fAlphaErr[n-1]=0.;
+		out.fBetaErr[n-1]=0.;
+		// factor of the power above in the denominator, and of D above in S
+		Double_t K=1./out.fBeta[n-1], invE=1.;
+		Float_t pw_up=in.fBinPw[n-1];
+		for(Int_t i=n-2; i>=0; i--){
+		  Double_t distance=10000.-in.fLidarAltitude-in.fAltitude[i];
+		  Double_t corr=1+in.fAlignCorr*sqrt(std::fabs(distance)/1000.);
+		  Float_t thickness=in.fThickness[i];
+		  Float_t A=(Sp-Sr)*(out.fBeta_M[i]+out.fBeta_M[i+1])*thickness;
+		  Double_t expA=FastExp(A);
+		  Float_t pw=in.fBinPw[i]*corr;
+		  Float_t denom_1=pw_up/out.fBeta[i+1];
+		  Float_t denom_2=Sp*(pw_up+pw*expA)*thickness;
+		  err=in.fBinPwErr[i]*corr;
+		  Double_t w=in.fODWeight ? in.fODWeight[i] : 0.;
+		  errors.Next(invE, K+Sp*thickness);
+		  Double_t var=errors.Bin(pw, err*err, expA, Sp*thickness*expA,
+		                          denom_1+denom_2, out.fBeta[i], Sp*w);
+		  out.fBetaErr[i]=sqrt(var);
+		  out.fAlphaErr[i]=Sp*out.fBetaErr[i];
+		  K=Sp*thickness;
+		  invE=1./expA;
+		  pw_up=pw;
+		  }
+		out.fODErr=sqrt(errors.GetVarOD());
+		}
+  };
+
+ /** @brief Aeronet inversion, two components, Fernald solution in closed
+  *  form with the Q1 and Q2 integrals
+  *
+  * Both integrals are accumulated from the reference downward, and the
+  * output of each bin only needs its own Q1 and Q2, so that a single
+  * backward sweep gives everything, without scratch. The errors are
+  * propagated in the same sweep.
+  */
+  struct AeronetAlgorithm {
+    /** @brief Name */
+    static std::string Name()                 {return "Aeronet";}
+    /** @brief Molecular and particle splits */
+    static Bool_t HasDetails()                {return true;}
+    /** @brief No scratch */
+    static Int_t GetScratchSize(Int_t)        {return 0;}
+
+    /** @brief Run the inversion */
+    static int Invert(const InversionInput& in, InversionOutput& out) {
+		Float_t Sr=8.*3.14159/3.; // 8.37 = Lidar Ratio alpha/beta for molecules = Rayleigh
+		Float_t Sp=in.fSp;        // Lidar Ratio alpha/beta for particles = Mie
+		Float_t sratio=in.fSratio;
+		Int_t n=in.fN;
+		const Float_t* binpw=in.fBinPw;
+		Float_t *alpha=out.fAlpha, *beta=out.fBeta;
+		Float_t *alpha_m=out.fAlpha_M, *beta_m=out.fBeta_M;
+		Float_t *alpha_p=out.fAlpha_P, *beta_p=out.fBeta_P;
+
+		// Reference values, aerosol free region
+		out.fAlpha0=in.fAlphaMol[n-1];
+		Float_t beta0=out.fAlpha0/Sr;
+		Float_t apfree0=beta0*(sratio-1)*Sp;
+
+		// Constants of the sweep
+		// signal and parameters at the reference, a single value instead
+		// of the average over a window
+		double sref = binpw[n-1];
+		double amfree = out.fAlpha0;
+		double apfree = apfree0;
+		double SpSr = Sp/8.37758;
+		double q1factor = -2.0*(SpSr-1.0);
+		double q2factor = 2.*Sp;
+		double norm = (Sp*sref)/(apfree+SpSr*amfree);
+		Float_t test2 = SpSr;
+
+		// First order errors, alpha_p+test2*am=Sp*P*Q1/paron
+		// with paron linear in the power, norm/sref at the reference
+		RecurrenceErrors errors;
+		Bool_t witherrors=(in.fBinPwErr!=0 && out.fAlphaErr!=0);
+		Double_t K=norm/sref;
+
+		// Backward sweep, Q1 and Q2 integrals are 0 at the reference
+		Float_t q1int=0., q2int=0.;
+		Float_t alpha_m_up=0., temp_up=0., Q1_up=0.;
+		for(Int_t i=n-1; i>=0; i--){
+		  // altitude bin width -- note that delta_Z>0, none at the reference
+		  Float_t step=i<n-1 ? in.fThickness[i] : 0.;
+		  Float_t am=in.fAlphaMol[i];
+		  // Q1 integral
+		  q1int=q1int+(0.5*step*(alpha_m_up+am));
+		  Float_t Q1=exp(q1factor*(-q1int));
+		  // Q2 integral
+		  Float_t temp=binpw[i]*Q1;
+		  q2int=q2int+(0.5*step*(temp_up+temp));
+		  Float_t Q2=q2factor*(-q2int);
+		  // numerator and denominator
+		  Float_t arith=Sp*binpw[i]*Q1;
+		  Float_t paron=norm-Q2;
+		  Float_t temp2=arith/paron;
+		  // final formula and other pieces
+		  alpha_m[i]= am;
+		  alpha_p[i]= temp2-test2*am;
+		  beta_p[i] = alpha_p[i]/Sp;
+		  alpha[i]  = alpha_p[i]+am;
+		  beta_m[i] = am/Sr;
+		  beta[i]   = beta_p[i]+beta_m[i];
+		  if(witherrors){
+		    Double_t err=in.fBinPwErr[i];
+		    if(i==n-1)
+		      errors.Reference(err*err);
+		    else{
+		      Double_t a=0.5*q2factor*step*Q1;
+		      Double_t w=in.fODWeight ? in.fODWeight[i] : 0.;
+		      errors.Next(1., K+0.5*q2factor*step*Q1_up);
+		      Double_t var=errors.Bin(binpw[i], err*err, Sp*Q1, a, paron, temp2, w);
+		      K=a;
+		      out.fAlphaErr[i]=sqrt(var);
+		      out.fBetaErr[i]=out.fAlphaErr[i]/Sp;
+		      }
+		    }
+		  alpha_m_up=am;
+		  temp_up=temp;
+		  Q1_up=Q1;
+		  }
+		if(witherrors){
+		  out.fAlphaErr[n-1]=0.;
+		  out.fBetaErr[n-1]=0.;
+		  out.fODErr=sqrt(errors.GetVarOD());
+		  }
+		return 0;
+		}
+
+    /** @brief Same sweep as Invert, for any scalar type */
+    template <class T>
+    static int InvertGeneric(const InversionInputOf<T>& in, InversionOutputOf<T>& out) {
+		const Float_t Sr=8.*3.14159/3.;
+		Int_t n=in.fN;
+		const T& Sp=in.fSp;
+		const T* binpw=in.fBinPw;
+		// Reference values, aerosol free region
+		T amfree=in.fAlphaMol[n-1];
+		T apfree=amfree/Sr*(in.fSratio-1.)*Sp;
+		T SpSr=Sp/8.37758;
+		T q1factor=-2.0*(SpSr-1.0);
+		T q2factor=2.*Sp;
+		T norm=(Sp*binpw[n-1])/(apfree+SpSr*amfree);
+		// Backward sweep, Q1 and Q2 integrals are 0 at the reference
+		T q1int=0., q2int=0., alpha_m_up=0., temp_up=0.;
+		for(Int_t i=n-1; i>=0; i--){
+		  T step=i<n-1 ? in.fThickness[i] : T(0.);
+		  const T& am=in.fAlphaMol[i];
+		  q1int+=0.5*step*(alpha_m_up+am);
+		  T temp=binpw[i]*exp(-q1factor*q1int);
+		  q2int+=0.5*step*(temp_up+temp);
+		  out.fAlpha_P[i]=Sp*temp/(norm+q2factor*q2int)-SpSr*am;
+		  out.fAlpha[i]=out.fAlpha_P[i]+am;
+		  alpha_m_up=am;
+		  temp_up=temp;
+		  }
+		return 0;
+		}
+  };
+
+ /** @brief Optimal estimation of the particle backscatter, regularized
+  *  least squares on the whole profile
+  *
+  * The state is u=beta_p/beta_m below the reference, u=sratio-1 at the
+  * reference as for Fernald84. The data are the differences of the log
+  * of the power corrected for mis-alignment between adjacent bins,
+  *   y_i=ln(P_i+1/P_i)=ln(beta_i+1/beta_i)-thickness_i*(alpha_i+alpha_i+1)
+  * with alpha=alpha_m+Sp*beta_m*u, weighted by the errors of the power,
+  * or all 1 without errors. The cost adds a smoothing of the second
+  * differences of u and a prior around sratio-1:
+  *   chi2=sum w_i*(y_i-f_i(u))^2+lambda*|D2 u|^2+|u-u_a|^2/sigma^2
+  * A row of the Jacobian only has two adjacent bins, the normal matrix is
+  * pentadiagonal and each Gauss-Newton step is a band LDL^T solve in O(n).
+  * Starts from the Fernald84 solution, the steps are shortened to keep
+  * beta positive.
+  *
+  * Adjacent differences share a bin, their correlation is neglected in
+  * the weights. The errors are not the posterior covariance but the first
+  * order errors of the power carried through the estimator, as for the
+  * other algorithms: one more band solve for the optical depth, and one
+  * for each bin, O(n^2) in all. They are only computed when the output
+  * has fAlphaErr, the weights only need fBinPwErr.
+  */
+  struct OptimalEstimationAlgorithm {
+    /** @brief Name */
+    static std::string Name()                 {return "OptimalEstimation";}
+    /** @brief Molecular and particle splits */
+    static Bool_t HasDetails()                {return true;}
+    /** @brief Fernald84 scratch, then 10*n doubles */
+    static Int_t GetScratchSize(Int_t n)      {return 2+20*n;}
+
+    /** @brief Run the inversion
+     *
+     * @return 0 if OK, 1 if the normal matrix is not positive definite,
+     *         2 if not converged within fOEMaxIter iterations, the outputs
+     *         are then those of the last iteration
+     */
+    static int Invert(const InversionInput& in, InversionOutput& out) {
+		const Float_t Sr=8.*3.14159/3.;
+		const Int_t w=2;
+		Int_t n=in.fN;
+		Int_t m=n-1;
+		Double_t Sp=in.fSp;
+		// Warm start, its scratch is the first float
+		InversionInput start=in;
+		start.fBinPwErr=0;
+		Fernald84Algorithm::Invert(start, out);
+		Double_t* u=(Double_t*)(((size_t)(out.fScratch+1)+7)&~(size_t)7);
+		Double_t* x=u+m;
+		Double_t* y=x+m;
+		Double_t* wt=y+m;
+		Double_t* jd=wt+m;
+		Double_t* ju=jd+m;
+		Double_t* bm=ju+m;
+		Double_t* a=bm+n;
+
+		// Data and weights
+		for(Int_t i=0; i<n; i++)
+		  bm[i]=in.fAlphaMol[i]/Sr;
+		Double_t pw_up=in.fBinPw[n-1];
+		for(Int_t i=m-1; i>=0; i--){
+		  Double_t distance=10000.-in.fLidarAltitude-in.fAltitude[i];
+		  Double_t pw=in.fBinPw[i]*(1+in.fAlignCorr*sqrt(std::fabs(distance)/1000.));
+		  y[i]=0.;
+		  wt[i]=0.;
+		  if(pw>0 && pw_up>0){
+		    y[i]=log(pw_up/pw);
+		    wt[i]=1.;
+		    if(in.fBinPwErr){
+		      Double_t s=in.fBinPwErr[i]/in.fBinPw[i];
+		      Double_t s_up=in.fBinPwErr[i+1]/in.fBinPw[i+1];
+		      Double_t var=s*s+s_up*s_up;
+		      wt[i]=var>0 ? 1./var : 0.;
+		      }
+		    }
+		  pw_up=pw;
+		  }
+		Double_t ua=in.fSratio-1.;
+		for(Int_t i=0; i<m; i++)
+		  u[i]=std::max(out.fBeta_P[i]/bm[i], -0.99);
+
+		// Gauss-Newton
+		Double_t lambda=in.fOESmoothing;
+		Double_t invs2=1./(in.fOEPriorSigma*in.fOEPriorSigma);
+		int rc=2;
+		out.fNIter=0;
+		for(; out.fNIter<in.fOEMaxIter && rc>0; out.fNIter++){
+		  std::fill(a, a+(w+1)*m, 0.);
+		  std::fill(x, x+m, 0.);
+		  for(Int_t i=0; i<m; i++){
+		    Double_t u_up=i+1<m ? u[i+1] : ua;
+		    Double_t t=in.fThickness[i];
+		    Double_t f=log(bm[i+1]*(1.+u_up))-log(bm[i]*(1.+u[i]))
+		              -t*(in.fAlphaMol[i]+in.fAlphaMol[i+1]+Sp*(bm[i]*u[i]+bm[i+1]*u_up));
+		    Double_t r=wt[i]*(y[i]-f);
+		    Double_t j=-1./(1.+u[i])-t*Sp*bm[i];
+		    Double_t j_up=1./(1.+u_up)-t*Sp*bm[i+1];
+		    jd[i]=j;
+		    ju[i]=i+1<m ? j_up : 0.;
+		    BandAt(a, w, i, i)+=wt[i]*j*j;
+		    x[i]+=j*r;
+		    if(i+1<m){
+		      BandAt(a, w, i+1, i+1)+=wt[i]*j_up*j_up;
+		      BandAt(a, w, i+1, i)+=wt[i]*j*j_up;
+		      x[i+1]+=j_up*r;
+		      }
+		    }
+		  // smoothing, rows u_k-1 -2 u_k + u_k+1 of D2
+		  const Double_t d2[3]={1., -2., 1.};
+		  for(Int_t k=1; k<m-1; k++){
+		    Double_t s=u[k-1]-2.*u[k]+u[k+1];
+		    for(Int_t p=0; p<3; p++){
+		      for(Int_t q=0; q<=p; q++)
+		        BandAt(a, w, k-1+p, k-1+q)+=lambda*d2[p]*d2[q];
+		      x[k-1+p]-=lambda*d2[p]*s;
+		      }
+		    }
+		  // prior
+		  for(Int_t i=0; i<m; i++){
+		    BandAt(a, w, i, i)+=invs2;
+		    x[i]-=(u[i]-ua)*invs2;
+		    }
+		  if(BandLDLTFactor(a, m, w)>0)
+		    return 1;
+		  BandLDLTSolve(a, m, w, x);
+		  // keep 1+u positive
+		  Double_t step=1.;
+		  for(Int_t i=0; i<m; i++)
+		    if(x[i]<0) step=std::min(step, -0.9*(1.+u[i])/x[i]);
+		  Double_t maxdu=0.;
+		  for(Int_t i=0; i<m; i++){
+		    u[i]+=step*x[i];
+		    maxdu=std::max(maxdu, std::fabs(step*x[i]));
+		    }
+		  if(maxdu<in.fOETolerance)
+		    rc=0;
+		  }
+
+		// Profiles, the reference is as for Fernald84
+		for(Int_t i=0; i<m; i++){
+		  out.fAlpha_M[i]=in.fAlphaMol[i];
+		  out.fBeta_M[i]=bm[i];
+		  out.fBeta_P[i]=bm[i]*u[i];
+		  out.fAlpha_P[i]=Sp*out.fBeta_P[i];
+		  out.fBeta[i]=bm[i]+out.fBeta_P[i];
+		  out.fAlpha[i]=in.fAlphaMol[i]+out.fAlpha_P[i];
+		  }
+
+		// Errors with the factorization and the Jacobian of the last step
+		if(in.fBinPwErr && out.fAlphaErr){
+		  for(Int_t k=0; k<m; k++){
+		    std::fill(x, x+m, 0.);
+		    x[k]=1.;
+		    BandLDLTSolve(a, m, w, x);
+		    out.fBetaErr[k]=bm[k]*sqrt(NoiseVariance(in, m, wt, jd, ju, x));
+		    out.fAlphaErr[k]=Sp*out.fBetaErr[k];
+		    }
+		  out.fAlphaErr[n-1]=0.;
+		  out.fBetaErr[n-1]=0.;
+		  // optical depth, sum of the weights times Sp*beta_m*u
+		  out.fODErr=0.;
+		  if(in.fODWeight){
+		    for(Int_t i=0; i<m; i++)
+		      x[i]=in.fODWeight[i]*Sp*bm[i];
+		    BandLDLTSolve(a, m, w, x);
+		    out.fODErr=sqrt(NoiseVariance(in, m, wt, jd, ju, x));
+		    }
+		  }
+		return rc;
+		}
+
+    /** @brief Variance of g^T u from the errors of the power, x=A^-1 g
+     *
+     * u moves by A^-1 J^T W dy for a change dy of the data, and y_i is
+     * ln P_i+1 - ln P_i, so that g^T u moves by h^T dlnP with
+     * h=D^T W J x, D the differences. The ln P are independent.
+     */
+    static Double_t NoiseVariance(const InversionInput& in, Int_t m, const Double_t* wt,
+                                  const Double_t* jd, const Double_t* ju, const Double_t* x) {
+		Double_t var=0., r_down=0.;
+		for(Int_t j=0; j<=m; j++){
+		  // row j-1 ends on bin j, row j starts on it
+		  Double_t r=j<m ? wt[j]*(jd[j]*x[j]+(j+1<m ? ju[j]*x[j+1] : 0.)) : 0.;
+		  Double_t h=r_down-r;
+		  if(in.fBinPw[j]>0){
+		    Double_t s=in.fBinPwErr[j]/in.fBinPw[j];
+		    var+=s*s*h*h;
+		    }
+		  r_down=r;
+		  }
+		return var;
+		}
+  };
+
+}; // namespace
+
+#endif
@@ -0,0 +1,115 @@
+/** @file KlettKernel.hh
+ *
+ * @brief Klett inversion recurrence, specialized on the Klett exponent
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_KLETTKERNEL
+#define LIDARTOOLS_KLETTKERNEL
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <cmath>
+
+namespace LidarTools {
+
+  // Policies compute in double precision, as pow does
+
+  /** @brief Klett exponent k=1, the production value, no pow at all */
+  struct KlettK1 {
+    /** @brief x^(1/k) */
+    static Double_t Root(Float_t x, Float_t)      {return x;}
+    /** @brief x^k */
+    static Double_t Power(Float_t x, Float_t)     {return x;}
+  };
+
+  /** @brief Klett exponent k=2 */
+  struct KlettK2 {
+    /** @brief x^(1/k) */
+    static Double_t Root(Float_t x, Float_t)      {return sqrt((Double_t)x);}
+    /** @brief x^k */
+    static Double_t Power(Float_t x, Float_t)     {return (Double_t)x*x;}
+  };
+
+  /** @brief Klett exponent k=1/2 */
+  struct KlettKHalf {
+    /** @brief x^(1/k) */
+    static Double_t Root(Float_t x, Float_t)      {return (Double_t)x*x;}
+    /** @brief x^k */
+    static Double_t Power(Float_t x, Float_t)     {return sqrt((Double_t)x);}
+  };
+
+  /** @brief Klett exponent k=2/3 */
+  struct KlettKTwoThirds {
+    /** @brief x^(1/k) */
+    static Double_t Root(Float_t x, Float_t)      {return x*sqrt((Double_t)x);}
+    /** @brief x^k */
+    static Double_t Power(Float_t x, Float_t)     {return cbrt((Double_t)x*x);}
+  };
+
+  /** @brief Any Klett exponent, pow at run time */
+  struct KlettKAny {
+    /** @brief x^(1/k), invk is 1/k */
+    static Double_t Root(Float_t x, Float_t invk) {return pow(x, invk);}
+    /** @brief x^k */
+    static Double_t Power(Float_t x, Float_t k)   {return pow(x, k);}
+  };
+
+  /** @brief Klett recurrence, integrated downward from the reference bin
+   *
+   *  alpha[n-1] is the reference extinction, alpha and beta are filled
+   *  for the bins below, with beta=l*alpha^k.
+   *  The Exponent policy gives x^(1/k) and x^k, so that the loop has no
+   *  pow call for the usual values of k.
+   *
+   * @param k the Klett exponent
+   * @param l the Klett factor, as in beta=l*alpha^k
+   * @param binpw the binned power, n values
+   * @param thickness the slab thickness between bin centers i and i+1, n-1 values
+   * @param n the number of bins up to the reference bin
+   * @param alpha the extinction, alpha[n-1] is set by the caller
+   * @param beta the backscatter
+   */
+  template <class Exponent>
+  void KlettRecurrence(Float_t k, Float_t l, const Float_t* binpw, const Float_t* thickness,
+                       Int_t n, Float_t* alpha, Float_t* beta)
+  {
+    Float_t invk=1/k;
+    Double_t root_m=Exponent::Root(binpw[n-1], invk);
+    for(Int_t i=n-2; i>=0; i--){
+      Double_t root=Exponent::Root(binpw[i], invk);
+      Float_t int_pw_m=(root_m+root)/2.*thickness[i];
+      alpha[i]=root/(root_m/alpha[i+1]-2*int_pw_m);
+      beta[i]=l*Exponent::Power(alpha[i], k);
+      root_m=root;
+      }
+  }
+
+  /** @brief Klett recurrence for one exponent policy, see KlettRecurrence */
+  typedef void (*KlettKernel)(Float_t, Float_t, const Float_t*, const Float_t*,
+                              Int_t, Float_t*, Float_t*);
+
+  /** @brief Return the Klett recurrence specialized for k, KlettKAny if
+   *  k has no specialization
+   *
+   * @param k the Klett exponent
+   */
+  inline KlettKernel GetKlettKernel(Float_t k)
+  {
+    if(k==1.f)
+      return &KlettRecurrence<KlettK1>;
+    if(k==2.f)
+      return &KlettRecurrence<KlettK2>;
+    if(k==0.5f)
+      return &KlettRecurrence<KlettKHalf>;
+    if(fabs(k-2.f/3.f)<1e-6)
+      return &KlettRecurrence<KlettKTwoThirds>;
+    return &KlettRecurrence<KlettKAny>;
+  }
+
+}; // namespace
+
+#endif
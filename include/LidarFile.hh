@@ -24,6 +24,8 @@
 #include <sash/Time.hh>
 #include <atmosphere/LidarEvent.hh>
 
+#include "LidarShot.hh"
+
 namespace LidarTools {
  
  /** @class LidarFile
@@ -118,12 +120,19 @@ namespace LidarTools {
     /** @brief Returns the array of altitudes
      * @return TArrayF
      */
-    TArrayF GetRange() const {return fRange;}
+    const TArrayF& GetRange() const {return fShot->GetRange();}
 
     /** @brief Returns the map of signal for all wavelength
      * @return std::map<Int_t, TArrayF>
      */
-    std::map<Int_t, TArrayF> GetSignalMap() const {return fSignalMap;}
+    const std::map<Int_t, TArrayF>& GetSignalMap() const {return fShot->GetSignalMap();}
+
+    /** @brief Returns the raw data, shared read-only without copy
+     *
+     * The shot stays valid after the LidarFile is read again or deleted.
+     * @return std::shared_ptr<const LidarShot>
+     */
+    std::shared_ptr<const LidarShot> GetShot() const {return fShot;}
 
   private:
     // methods
@@ -173,21 +182,14 @@ namespace LidarTools {
     /** @brief File Handler for ROOT file*/
     SashFile::FileHandler *fFileHandler;
         
-    /** @brief Array of raw altitudes */
-    TArrayF fRange;
-    /** @brief Raw data map
-     * 
-     * The key is the wavelength as an integer.
-     * 
-     * The value is an array of float
-     */
-    std::map<Int_t, TArrayF> fSignalMap;
+    /** @brief Raw data, range and signal map */
+    std::shared_ptr<LidarShot> fShot; //!
     
     
   protected:
     
 #if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
-    ClassDef(LidarTools::LidarFile,2);
+    ClassDef(LidarTools::LidarFile,3);
 #endif
 
   }; // class
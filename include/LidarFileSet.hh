@@ -70,12 +70,17 @@ namespace LidarTools {
     /** @brief Returns the array of altitudes
      * @return TArrayF
      */
-    TArrayF GetRange() const {return fRange;}
+    const TArrayF& GetRange() const {return fShot->GetRange();}
 
     /** @brief Returns the map of signal for all wavelength
      * @return std::map<Int_t, TArrayF>
      */
-    std::map<Int_t, TArrayF> GetSignalMap() const {return fSignalMap;}
+    const std::map<Int_t, TArrayF>& GetSignalMap() const {return fShot->GetSignalMap();}
+
+    /** @brief Returns the merged data, shared read-only without copy
+     * @return std::shared_ptr<const LidarShot>
+     */
+    std::shared_ptr<const LidarShot> GetShot() const {return fShot;}
 
   private:
     // methods
@@ -87,16 +92,8 @@ namespace LidarTools {
     /** @brief Input file name with the list of file paths */
     std::string fFilePathList;
 
-    /** @brief Array of raw altitudes */
-    TArrayF fRange;
-    
-    /** @brief Raw data map
-     * 
-     * The key is the wavelength as an integer.
-     * 
-     * The value is an array of float
-     */
-    std::map<Int_t, TArrayF> fSignalMap;
+    /** @brief Merged data, range and signal map */
+    std::shared_ptr<LidarShot> fShot; //!
     
     /** @brief Vector of LidarFile pointers */
     std::vector<LidarFile*> fLidarFileVec;
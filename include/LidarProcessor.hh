@@ -19,6 +19,7 @@
 #include "LidarTools/LidarFile.hh"
 #include "LidarTools/Analyser.hh"
 #include "LidarTools/Plotter.hh"
+#include "LidarTools/ResultCache.hh"
 
 namespace LidarTools {
 
@@ -72,6 +73,22 @@ namespace LidarTools {
      *
      */
     int Init();
+
+    /** @brief Initialize for a new run number
+     *
+     * The Analyser, and its configuration, are reused.
+     *
+     * @param runnumber the run number
+     */
+    int Init(Int_t);
+
+    /** @brief Initialize for a new file
+     *
+     * The Analyser, and its configuration, are reused.
+     *
+     * @param filename the file name as std::string
+     */
+    int Init(std::string);
     
     /** @brief Overwrite a parameter of the analysis configuration.
      *
@@ -81,6 +98,9 @@ namespace LidarTools {
     void OverwriteConfigParam(std::string, std::string);
     
     /** @brief  Launch data processing
+     *
+     * With a cache, a result already there for the same raw data,
+     * configuration and offset is not processed again, nor displayed.
      *
      * @param offset apply LidarAltitude offset on all plots
      * @param display a bool to decide to dispaly or not a ROOT TCanvas
@@ -88,11 +108,33 @@ namespace LidarTools {
      */
     int Process(Bool_t offset, Bool_t display);
 
+    /** @brief Return true if the shot was rejected by the early classification
+     *
+     * Process then returns 1, the plots, with the classification of each
+     * wavelength, can still be saved with SaveAs.
+     * @see Analyser::Classify
+     */
+    Bool_t IsRejected() {return fCacheHit ? fCacheRejected : (fAnalyser && fAnalyser->IsRejected());}
+
     /** @brief Save data analysis plots to ROOT file
+     *
+     * The file is copied from the cache if Process found it there, and
+     * stored in the cache otherwise. Nothing is saved nor stored if the
+     * last Process made no plots, the shot failed without being rejected.
      *
      * @param fname the output ROOT file path
      */
     void SaveAs(std::string);
+
+    /** @brief Use a result cache, not owned, 0 for none
+     *
+     * @param cache the cache, shared by all the runs of a campaign
+     * @see ResultCache
+     */
+    void SetCache(LidarTools::ResultCache* cache) {fCache=cache;}
+
+    /** @brief Return true if the result of the last Process comes from the cache */
+    Bool_t IsCached() const {return fCacheHit;}
     
     /** @brief Get a pointer to the Analyser
      * 
@@ -102,6 +144,8 @@ namespace LidarTools {
 
     /** @brief Get a pointer to the Plotter
      * 
+     *  Deleted by the next Process, 0 if the last Process made no plots
+     *
      *  @return Plotter
      */
     LidarTools::Plotter* GetPlotter() {return fPlotter;}
@@ -120,6 +164,17 @@ namespace LidarTools {
     LidarTools::Analyser  *fAnalyser;
     /** @brief a Plotter to display results */
     LidarTools::Plotter   *fPlotter;
+
+    /** @brief a result cache, not owned */
+    LidarTools::ResultCache *fCache; //!
+    /** @brief cache key of the last Process */
+    std::string fCacheKey; //!
+    /** @brief true if the last Process found its result in the cache */
+    Bool_t fCacheHit; //!
+    /** @brief rejection of the cached result */
+    Bool_t fCacheRejected; //!
+    /** @brief offset option of the last Process */
+    Bool_t fApplyOffset; //!
   
   protected:
     
@@ -0,0 +1,149 @@
+/** @file LidarShot.hh
+ *
+ * @brief LidarShot class definition
+ *
+ * Raw data of one Lidar shot, shared read-only between LidarFile,
+ * LidarFileSet and Analyser
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_LIDARSHOT
+#define LIDARTOOLS_LIDARSHOT
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#include <TArrayF.h>
+#endif
+
+#include <map>
+#include <memory>
+
+namespace LidarTools {
+
+ /** @class LidarShot
+  *
+  * @brief Raw range and signal arrays of one Lidar shot
+  *
+  * The arrays are allocated once, by the reader filling the shot, and
+  * then handed over as a std::shared_ptr<const LidarShot>: holders of the
+  * shot never copy the raw traces and can not modify them.
+  * A reader that needs to load new data creates a new shot instead of
+  * modifying a shot that was already handed over.
+  *
+  * @see LidarFile LidarFileSet Analyser
+  */
+  class LidarShot
+  {
+
+  public:
+
+    /** @brief Constructor of an empty shot, to be filled by a reader
+     *
+     */
+    LidarShot();
+
+    /** @brief Constructor copying existing arrays
+     *
+     * @param range the array of raw altitudes
+     * @param signalmap the map of raw signals for all wavelengths
+     */
+    LidarShot(const TArrayF& range, const std::map<Int_t, TArrayF>& signalmap);
+
+    /** @brief Constructor taking over a map of signals
+     *
+     * The signal arrays are not copied, signalmap is left empty.
+     *
+     * @param range the array of raw altitudes
+     * @param signalmap the map of raw signals for all wavelengths
+     */
+    LidarShot(const TArrayF& range, std::map<Int_t, TArrayF>&& signalmap);
+
+    /** @brief Destructor
+     *
+     */
+    virtual ~LidarShot() {}
+
+    // Filling, for readers only
+    /** @brief Size the range array to n points
+     *
+     * @param n the number of points
+     * @return a pointer to the first element, to be filled
+     */
+    Float_t* SetRange(Int_t n);
+
+    /** @brief Copy a range array
+     *
+     * @param range the array of raw altitudes
+     */
+    void SetRange(const TArrayF& range)  {fRange=range;}
+
+    /** @brief Size the signal array of one wavelength to n points
+     *
+     * @param wl the wavelength as an integer
+     * @param n the number of points
+     * @return a pointer to the first element, to be filled
+     */
+    Float_t* SetSignal(Int_t wl, Int_t n);
+
+    /** @brief Copy the signal array of one wavelength
+     *
+     * @param wl the wavelength as an integer
+     * @param signal the signal array
+     */
+    void SetSignal(Int_t wl, const TArrayF& signal) {fSignalMap[wl]=signal;}
+
+    /** @brief Return a modifiable signal array, e.g. to merge shots
+     *
+     * @param wl the wavelength as an integer
+     * @return a pointer to the array, 0 if the wavelength is unknown
+     */
+    TArrayF* GetSignal(Int_t wl);
+
+    // Getters
+    /** @brief Returns the array of raw altitudes */
+    const TArrayF& GetRange() const      {return fRange;}
+
+    /** @brief Returns the map of signal for all wavelength */
+    const std::map<Int_t, TArrayF>& GetSignalMap() const {return fSignalMap;}
+
+    /** @brief Returns the signal array of one wavelength
+     *
+     * @param wl the wavelength as an integer
+     * @return a pointer to the array, 0 if the wavelength is unknown
+     */
+    const TArrayF* GetSignal(Int_t wl) const;
+
+    /** @brief Returns the memory held by the raw arrays in bytes */
+    Long64_t GetBytes() const;
+
+    /** @brief Returns a hash of the raw data, FNV-1a of the range and
+     *  of each wavelength and signal, equal shots have the same hash
+     *
+     * @see ResultCache
+     */
+    ULong64_t GetHash() const;
+
+  private:
+    /** @brief Array of raw altitudes */
+    TArrayF fRange;
+
+    /** @brief Raw data map
+     *
+     * The key is the wavelength as an integer.
+     *
+     * The value is an array of float
+     */
+    std::map<Int_t, TArrayF> fSignalMap;
+
+  protected:
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+    ClassDef(LidarTools::LidarShot,1);
+#endif
+
+  }; // class
+
+}; // namespace
+
+#endif
@@ -20,6 +20,15 @@
 #pragma link C++ class LidarTools::AtmoPlotter+;
 #pragma link C++ class LidarTools::GlidingAveFilter+;
 #pragma link C++ class LidarTools::SavGolFilter+;
+#pragma link C++ class LidarTools::ChannelRegistry+;
+#pragma link C++ class LidarTools::ChannelBuffer+;
+#pragma link C++ class LidarTools::FloatView;
+#pragma link C++ class LidarTools::LidarShot+;
+#pragma link C++ class LidarTools::AODTable+;
+#pragma link C++ class LidarTools::AnalysisConfig+;
+#pragma link C++ class LidarTools::SweepSpec+;
+#pragma link C++ class LidarTools::SweepRunner+;
+#pragma link C++ class LidarTools::ResultCache+;
 
 #pragma link C++ class map<string,string>;
 #pragma link C++ class pair<string,string>;
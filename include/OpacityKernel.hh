@@ -0,0 +1,149 @@
+/** @file OpacityKernel.hh
+ *
+ * @brief Opacity, transmission and optical depth integration of the
+ *  extinction profiles of an inversion
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_OPACITYKERNEL
+#define LIDARTOOLS_OPACITYKERNEL
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include "FastMath.hh"
+
+namespace LidarTools {
+
+ /** @brief Optical depths in the [TauAltMin, TauAltMax] window */
+  struct OpticalDepths {
+    /** @brief total */
+    Float_t fOD;
+    /** @brief molecules */
+    Float_t fOD_M;
+    /** @brief particles, AOD */
+    Float_t fOD_P;
+    /** @brief model total */
+    Float_t fODModel;
+    /** @brief model particles, model minus molecules */
+    Float_t fODModel_P;
+  };
+
+ /** @brief Cumulative opacity and transmission profiles, n values each
+  *
+  * The molecular and particle profiles may be 0, they are then skipped.
+  */
+  struct OpacityProfiles {
+    /** @brief total opacity */
+    Float_t* fOpacity;
+    /** @brief molecular opacity */
+    Float_t* fOpacity_M;
+    /** @brief particle opacity */
+    Float_t* fOpacity_P;
+    /** @brief model opacity */
+    Float_t* fOpacityModel;
+    /** @brief total transmission */
+    Float_t* fTransmission;
+    /** @brief molecular transmission */
+    Float_t* fTransmission_M;
+    /** @brief particle transmission */
+    Float_t* fTransmission_P;
+    /** @brief model transmission */
+    Float_t* fTransmissionModel;
+  };
+
+  /** @brief Integrate extinction profiles into opacity, transmission and
+   *  optical depths
+   *
+   *  One pass accumulates the four opacities and the optical depths of the
+   *  bins overlapping [tauMin, tauMax], a second pass over the opacities,
+   *  still in cache, gives the transmissions with FastExpMinus.
+   *
+   * @param edges the n+1 bin edges in altitude
+   * @param n the number of bins
+   * @param tauMin the minimum altitude of the optical depths
+   * @param tauMax the maximum altitude of the optical depths
+   * @param alpha the total extinction
+   * @param alpha_M the molecular extinction, may be 0
+   * @param alpha_P the particle extinction, may be 0
+   * @param alphaModel the model extinction
+   * @param profiles the profiles, allocated by the caller
+   * @param od the optical depths
+   */
+  inline void IntegrateOpacity(const Float_t* edges, Int_t n, Float_t tauMin, Float_t tauMax,
+                               const Float_t* alpha, const Float_t* alpha_M,
+                               const Float_t* alpha_P, const Float_t* alphaModel,
+                               OpacityProfiles& profiles, OpticalDepths& od)
+  {
+    Float_t od_m=0., od_t=0., od_p=0., od_model=0., od_model_p=0.;
+    Float_t opacity=0., opacity_M=0., opacity_P=0., opacitymodel=0.;
+    for(Int_t i=0; i<n; i++){
+      Float_t width=edges[i+1]-edges[i];
+      Float_t area_M     =alpha_M ? alpha_M[i]*width : 0;
+      Float_t area       =alpha[i]*width;
+      Float_t area_P     =alpha_P ? alpha_P[i]*width : 0;
+      Float_t areamodel  =alphaModel[i]*width;
+      Float_t areamodel_P=areamodel-area_M;
+      opacity+=area;
+      opacity_M+=area_M;
+      opacity_P+=area_P;
+      opacitymodel+=areamodel;
+      profiles.fOpacity[i]=opacity;
+      if(profiles.fOpacity_M) profiles.fOpacity_M[i]=opacity_M;
+      if(profiles.fOpacity_P) profiles.fOpacity_P[i]=opacity_P;
+      profiles.fOpacityModel[i]=opacitymodel;
+      if(edges[i+1]>=tauMin && edges[i]<=tauMax){
+        od_m+=area_M;
+        od_t+=area;
+        od_p+=area_P;
+        od_model+=areamodel;
+        od_model_p+=areamodel_P;
+        }
+      }
+    od.fOD=od_t;
+    od.fOD_M=od_m;
+    od.fOD_P=od_p;
+    od.fODModel=od_model;
+    od.fODModel_P=od_model_p;
+
+    FastExpMinus(profiles.fOpacity, profiles.fTransmission, n);
+    FastExpMinus(profiles.fOpacityModel, profiles.fTransmissionModel, n);
+    if(profiles.fOpacity_M && profiles.fTransmission_M)
+      FastExpMinus(profiles.fOpacity_M, profiles.fTransmission_M, n);
+    if(profiles.fOpacity_P && profiles.fTransmission_P)
+      FastExpMinus(profiles.fOpacity_P, profiles.fTransmission_P, n);
+  }
+
+  /** @brief Total and particle optical depths in [tauMin, tauMax], without
+   *  the profiles, summed as in IntegrateOpacity, for any scalar type
+   *
+   * @param edges the n+1 bin edges in altitude
+   * @param n the number of bins
+   * @param tauMin the minimum altitude of the optical depths
+   * @param tauMax the maximum altitude of the optical depths
+   * @param alpha the total extinction
+   * @param alpha_P the particle extinction, may be 0
+   * @param od the total optical depth
+   * @param aod the particle optical depth, 0 without alpha_P
+   */
+  template <class T>
+  inline void IntegrateOpticalDepth(const Float_t* edges, Int_t n, Float_t tauMin, Float_t tauMax,
+                                    const T* alpha, const T* alpha_P, T& od, T& aod)
+  {
+    T od_t=0., od_p=0.;
+    for(Int_t i=0; i<n; i++){
+      if(edges[i+1]<tauMin || edges[i]>tauMax)
+        continue;
+      Float_t width=edges[i+1]-edges[i];
+      od_t+=alpha[i]*width;
+      if(alpha_P) od_p+=alpha_P[i]*width;
+      }
+    od=od_t;
+    aod=od_p;
+  }
+
+}; // namespace
+
+#endif
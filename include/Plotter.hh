@@ -162,6 +162,12 @@ namespace LidarTools {
      * @param wl the wavelength
      */    
     void InitODResults(Int_t);
+
+    /** @brief Initialize the early classification TGraph
+     * 
+     * @param wl the wavelength
+     */    
+    void InitClassification(Int_t);
     
     /** @brief Initialize the Angstroem Exponent profile TGraph
      * 
@@ -250,6 +256,19 @@ namespace LidarTools {
      * @param wl the wavelength
      */    
     void FillODResults(Int_t);
+
+    /** @brief Fill the early classification TGraph
+     *  for the given wave length
+     * 
+     * Points are 1 verdict, 2 reasons, 3 background drift in %,
+     * 4 background RMS, 5 S/N of the lowest coarse bin,
+     * 6 cloud altitude above the Lidar, 7 clipped samples,
+     * 8 altitude above the Lidar where the signal is lost
+     * 
+     * @param wl the wavelength
+     * @see Analyser::Classify
+     */    
+    void FillClassification(Int_t);
     
    
     /** @brief Fill the Angstroem Exponent profile TGraph
@@ -508,6 +527,15 @@ namespace LidarTools {
     TGraph *GetODResults(Int_t wl) {if(fODResultsMap.count(wl))return fODResultsMap[wl];
                                             else return 0;}
 
+    /** @brief Returns a pointer to the early classification TGraph
+     *  of the given wavelength
+     * 
+     * @param wl the wavelength
+     * @return TGraph *
+     */
+    TGraph *GetClassification(Int_t wl) {if(fClassificationMap.count(wl))return fClassificationMap[wl];
+                                            else return 0;}
+
     /** @brief Returns a pointer to the Angstroem Exponent profile TGraph
      * 
      * @return TGraph *
@@ -730,6 +758,12 @@ namespace LidarTools {
      * The key is the wavelength, the value is a pointer to the TGraph
      */
     std::map<Int_t, TGraph*> fODResultsMap;
+
+    /** @brief Map of TGraph of early classification
+     * 
+     * The key is the wavelength, the value is a pointer to the TGraph
+     */
+    std::map<Int_t, TGraph*> fClassificationMap;
     
     /** @brief TGraph of Angstroem Exponent
      * 
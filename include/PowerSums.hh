@@ -0,0 +1,107 @@
+/** @file PowerSums.hh
+ *
+ * @brief PowerSums class definition
+ *
+ * Cumulative sums of the power and of its square for all Lidar channels
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_POWERSUMS
+#define LIDARTOOLS_POWERSUMS
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <vector>
+
+namespace LidarTools {
+
+ /** @class PowerSums
+  *
+  * @brief Prefix sums of a signal and of its square, for each channel slot
+  *
+  * Once built in one pass, the sum, mean and standard deviation of any
+  * range of samples [from, to) are given in O(1), so that any binning,
+  * linear, logarithmic, overlapping or adaptive, costs O(number of bins).
+  *
+  * Sums are accumulated in double precision, on the signal shifted by its
+  * first sample, which limits the cancellation in the variance.
+  * Memory is kept between shots, as for a ChannelBuffer.
+  *
+  * @see ChannelBuffer Analyser::RebinPower
+  */
+  class PowerSums
+  {
+
+  public:
+
+    /** @brief Constructor
+     *
+     */
+    PowerSums();
+
+    /** @brief Destructor
+     *
+     */
+    virtual ~PowerSums() {}
+
+    /** @brief Build the prefix sums of a channel slot
+     *
+     * @param slot the channel slot index
+     * @param data the signal
+     * @param n the number of samples
+     */
+    void Build(Int_t slot, const Float_t* data, Int_t n);
+
+    /** @brief Return the number of samples of a slot, 0 if not built */
+    Int_t GetSize(Int_t slot) const {
+		if(slot>=0 && slot<(Int_t)fSize.size()) return fSize[slot];
+		return 0;
+		}
+
+    /** @brief Return the sum of the samples [from, to) of a slot */
+    Double_t GetSum(Int_t slot, Int_t from, Int_t to) const {
+		const Double_t* sum=&fSum[slot][0];
+		return sum[to]-sum[from]+(to-from)*fShift[slot];
+		}
+
+    /** @brief Return the mean of the samples [from, to) of a slot, no check on the range */
+    Double_t GetMean(Int_t slot, Int_t from, Int_t to) const {
+		const Double_t* sum=&fSum[slot][0];
+		return (sum[to]-sum[from])/(to-from)+fShift[slot];
+		}
+
+    /** @brief Return the unbiased variance of the samples [from, to) of a slot,
+     *  0 for less than 2 samples
+     */
+    Double_t GetVariance(Int_t slot, Int_t from, Int_t to) const;
+
+    /** @brief Return the standard deviation of the samples [from, to) of a slot */
+    Double_t GetStdDev(Int_t slot, Int_t from, Int_t to) const;
+
+    /** @brief Set all slot sizes to 0, memory is kept */
+    void Clear();
+
+    /** @brief Free memory */
+    void Release();
+
+    /** @brief Return the allocated memory in bytes */
+    Long64_t GetBytes() const;
+
+  private:
+    /** @brief prefix sums of the shifted signal, n+1 values per slot */
+    std::vector< std::vector<Double_t> > fSum;
+    /** @brief prefix sums of the squared shifted signal, n+1 values per slot */
+    std::vector< std::vector<Double_t> > fSum2;
+    /** @brief shift of each slot, its first sample */
+    std::vector<Double_t> fShift;
+    /** @brief number of samples of each slot */
+    std::vector<Int_t> fSize;
+
+  }; // class
+
+}; // namespace
+
+#endif
@@ -0,0 +1,101 @@
+/** @file RecurrenceErrors.hh
+ *
+ * @brief First order error propagation through the inversion recurrences
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_RECURRENCEERRORS
+#define LIDARTOOLS_RECURRENCEERRORS
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+namespace LidarTools {
+
+ /** @class RecurrenceErrors
+  *
+  * @brief Variances of a downward recurrence y=E*x/(S+a*x)
+  *
+  * Klett, Fernald84 and Aeronet all solve, from the reference downward,
+  * y_j=E_j*x_j/D_j with D_j=S_j+a_j*x_j, x_j the signal of bin j and S_j
+  * linear in the signals above: S_j=S_{j+1}/E'_{j+1}+c_j*x_{j+1}.
+  * Carrying Var(S), the variance of the partial optical depth T from the
+  * reference down to the current bin and Cov(T,S) gives the exact first
+  * order variances of every y_j and of the optical depth in one pass,
+  * for independent errors of the x_j.
+  *
+  * For each bin below the reference: Next, then Bin.
+  */
+  class RecurrenceErrors
+  {
+
+  public:
+    /** @brief Constructor */
+    RecurrenceErrors() {Reference(0.);}
+
+    /** @brief Start at the reference bin, whose output is fixed
+     *
+     * @param varx the variance of the signal at the reference
+     */
+    void Reference(Double_t varx) {
+		fVarS=0; fCovTS=0; fVarT=0;
+		fHS=0; fHX=0; fVarX=varx;
+		}
+
+    /** @brief Move to the next bin down
+     *
+     * @param invE the factor of S of the bin above in S of this bin
+     * @param c the factor of the signal of the bin above in S of this bin
+     */
+    void Next(Double_t invE, Double_t c) {
+		fVarT+=fHS*fHS*fVarS+2*fHS*fCovTS+fHX*fHX*fVarX;
+		fCovTS=invE*(fCovTS+fHS*fVarS)+fHX*c*fVarX;
+		fVarS=invE*invE*fVarS+c*c*fVarX;
+		}
+
+    /** @brief Variance of the output of the current bin
+     *
+     * @param x the signal
+     * @param varx the variance of the signal
+     * @param E the numerator factor
+     * @param a the factor of x in the denominator
+     * @param D the denominator
+     * @param y the output, E*x/D
+     * @param gw the weight of y in the optical depth, 0 outside of its window
+     * @return the variance of y
+     */
+    Double_t Bin(Double_t x, Double_t varx, Double_t E, Double_t a, Double_t D,
+                 Double_t y, Double_t gw) {
+		Double_t dydx=E*(D-a*x)/(D*D);
+		Double_t dyds=-y/D;
+		fHX=gw*dydx;
+		fHS=gw*dyds;
+		fVarX=varx;
+		return dydx*dydx*varx+dyds*dyds*fVarS;
+		}
+
+    /** @brief Variance of the optical depth down to the current bin */
+    Double_t GetVarOD() const {
+		return fVarT+fHS*fHS*fVarS+2*fHS*fCovTS+fHX*fHX*fVarX;
+		}
+
+  private:
+    /** @brief Variance of S of the current bin */
+    Double_t fVarS;
+    /** @brief Covariance of the optical depth above the current bin and S */
+    Double_t fCovTS;
+    /** @brief Variance of the optical depth above the current bin */
+    Double_t fVarT;
+    /** @brief Optical depth derivative with S of the current bin */
+    Double_t fHS;
+    /** @brief Optical depth derivative with the signal of the current bin */
+    Double_t fHX;
+    /** @brief Variance of the signal of the current bin */
+    Double_t fVarX;
+  }; // class
+
+}; // namespace
+
+#endif
@@ -0,0 +1,188 @@
+/** @file ResultCache.hh
+ *
+ * @brief ResultCache class definition
+ *
+ * Content addressed cache of analysis result files on disk
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_RESULTCACHE
+#define LIDARTOOLS_RESULTCACHE
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <map>
+#include <string>
+
+namespace LidarTools {
+
+/** @class ResultCache
+ *
+ * @brief Result files kept in a directory, keyed by the raw data and the
+ *  configuration they were computed from
+ *
+ * The key of a result is made by MakeKey from LidarShot::GetHash and
+ * Analyser::GetConfigFingerprint, so that it changes with any raw sample
+ * and with any parameter of the effective configuration.
+ *
+ * Each entry is one file, a header with the status, size and checksum of
+ * the result, followed by the result file itself. Entries are written to
+ * a temporary file and renamed, an entry is never seen half written, and
+ * an entry whose size or checksum does not match is removed and counted
+ * as a miss.
+ *
+ * When the directory grows above the size limit, the least recently used
+ * entries are removed. The last use of an entry is the modification time
+ * of its file, so that the order is kept from one job to the next.
+ * Several jobs can share a directory, each one then only enforces the
+ * limit on the entries it knows of.
+ *
+ * @see LidarProcessor::SetCache
+*/
+  class ResultCache
+  {
+
+  public:
+    /** @brief class constructor, creates the directory if needed and
+     *  lists the entries already there
+     *
+     * @param dir the cache directory
+     * @param maxbytes the size limit in bytes, 0 for no limit
+     * @param verbose a boolean for verbosity
+     */
+    ResultCache(std::string dir, Long64_t maxbytes=0, Bool_t verbose=false);
+
+    /** @brief class destructor */
+    virtual ~ResultCache() {}
+
+    /** @brief Make a key from the raw data and configuration hashes
+     *
+     * @param data the raw data hash, e.g. LidarShot::GetHash
+     * @param config the configuration fingerprint
+     * @param variant anything else the result depends on, e.g. options
+     * @return 48 hexadecimal digits
+     */
+    static std::string MakeKey(ULong64_t data, ULong64_t config, std::string variant="");
+
+    /** @brief Look for an entry, counted as a hit or a miss
+     *
+     * @param key the entry key
+     * @param status set to the status given to Store
+     * @return true if the entry is there with a valid header
+     */
+    Bool_t Lookup(std::string key, Int_t& status);
+
+    /** @brief Copy the result of an entry to a file, checking its checksum
+     *
+     * @param key the entry key
+     * @param outfile the output file name
+     * @return 0 if OK, 1 if there is no such entry, 2 if the entry was
+     *         corrupted and removed, 3 if the output could not be written
+     */
+    int Fetch(std::string key, std::string outfile);
+
+    /** @brief Store a result file, then remove the least recently used
+     *  entries above the size limit
+     *
+     * @param key the entry key
+     * @param file the result file
+     * @param status a status returned by Lookup, e.g. a return code
+     * @return 0 if OK, 1 if the file could not be read, 2 if the entry
+     *         could not be written
+     */
+    int Store(std::string key, std::string file, Int_t status=0);
+
+    /** @brief Set the size limit, removes entries above it
+     *
+     * @param maxbytes the size limit in bytes, 0 for no limit
+     */
+    void SetMaxBytes(Long64_t maxbytes);
+
+    /** @brief Set verbosity on or off
+     *
+     * @param verbose a bool, true or false
+     */
+    void SetVerbose(Bool_t verbose) {fVerbose=verbose;}
+
+    /** @brief Returns the number of entries */
+    Int_t GetNEntries() const {return fEntries.size();}
+
+    /** @brief Returns the size of all entries in bytes */
+    Long64_t GetBytes() const {return fBytes;}
+
+    /** @brief Returns the number of hits */
+    Long64_t GetHits() const {return fHits;}
+
+    /** @brief Returns the number of misses */
+    Long64_t GetMisses() const {return fMisses;}
+
+    /** @brief Returns the number of entries removed by the size limit */
+    Long64_t GetEvictions() const {return fEvictions;}
+
+    /** @brief Returns the fraction of lookups that were hits */
+    Double_t GetHitRate() const;
+
+    /** @brief Print the number of entries, size, hits and misses */
+    void PrintStats() const;
+
+  private:
+    /** @brief An entry, size and last use */
+    struct Entry
+    {
+      Long64_t fBytes;
+      Long64_t fTick;
+    };
+
+    /** @brief Path of the file of an entry */
+    std::string GetPath(std::string key) const;
+
+    /** @brief Mark an entry as the most recently used */
+    void Touch(std::string key);
+
+    /** @brief Add an entry as the most recently used, replaces it if known */
+    void Add(std::string key, Long64_t bytes);
+
+    /** @brief Remove an entry and its file */
+    void Remove(std::string key);
+
+    /** @brief Remove the least recently used entries above the size limit */
+    void Evict();
+
+    /** @brief boolean to print some results if true */
+    Bool_t fVerbose;
+
+    /** @brief Cache directory */
+    std::string fDir;
+    /** @brief Size limit in bytes, 0 for no limit */
+    Long64_t fMaxBytes;
+
+    /** @brief Entries by key */
+    std::map<std::string, Entry> fEntries; //!
+    /** @brief Entry keys by last use */
+    std::map<Long64_t, std::string> fLru; //!
+    /** @brief Last use counter */
+    Long64_t fTick;
+    /** @brief Size of all entries */
+    Long64_t fBytes;
+
+    /** @brief Number of lookups that found a valid entry */
+    Long64_t fHits;
+    /** @brief Number of lookups that did not */
+    Long64_t fMisses;
+    /** @brief Number of entries removed by the size limit */
+    Long64_t fEvictions;
+
+  protected:
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+    ClassDef(LidarTools::ResultCache,1);
+#endif
+
+  }; // class
+
+}; // namespace
+
+#endif
@@ -0,0 +1,115 @@
+/** @file RootFinder.hh
+ *
+ * @brief Brent root finder
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_ROOTFINDER
+#define LIDARTOOLS_ROOTFINDER
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+namespace LidarTools {
+
+  /** @brief Root of f between a and b, Brent 1973
+   *
+   * Inverse quadratic interpolation or secant steps, with a bisection
+   * whenever they would not shrink the bracket fast enough, so that it
+   * converges at least as fast as bisection. f(a) and f(b) must have
+   * opposite signs. The search stops as soon as f is not a number, so that
+   * f can return NaN to abort it.
+   *
+   * @param f the function, called as f(x) with a Double_t
+   * @param a one end of the bracket
+   * @param b the other end of the bracket
+   * @param tol the absolute tolerance on the root
+   * @param maxIter the maximal number of iterations
+   * @param root the root, the last estimate if not converged
+   * @param froot f at the root
+   * @param nIter the number of iterations, f is called nIter+2 times
+   * @return 0 if OK, 1 if f(a) and f(b) have the same sign,
+   *         2 if not converged in maxIter iterations, 3 if f is not a number
+   */
+  template <class F>
+  inline int BrentRoot(const F& f, Double_t a, Double_t b, Double_t tol, Int_t maxIter,
+                       Double_t& root, Double_t& froot, Int_t& nIter)
+  {
+    Double_t fa=f(a), fb=f(b);
+    nIter=0;
+    root=b;
+    froot=fb;
+    if(std::isnan(fa) || std::isnan(fb))
+      return 3;
+    if((fa>0 && fb>0) || (fa<0 && fb<0))
+      return 1;
+    // b is the best estimate, [b,c] the bracket, a the previous estimate
+    Double_t c=a, fc=fa, d=b-a, e=d;
+    for(nIter=0; nIter<maxIter; nIter++){
+      if((fb>0 && fc>0) || (fb<0 && fc<0)){
+        c=a; fc=fa; d=b-a; e=d;
+        }
+      if(fabs(fc)<fabs(fb)){
+        a=b; b=c; c=a;
+        fa=fb; fb=fc; fc=fa;
+        }
+      Double_t tol1=2.*DBL_EPSILON*fabs(b)+0.5*tol;
+      Double_t xm=0.5*(c-b);
+      if(fabs(xm)<=tol1 || fb==0.){
+        root=b;
+        froot=fb;
+        return 0;
+        }
+      if(fabs(e)>=tol1 && fabs(fa)>fabs(fb)){
+        // interpolation, secant if only two points
+        Double_t s=fb/fa, p, q;
+        if(a==c){
+          p=2.*xm*s;
+          q=1.-s;
+          }
+        else{
+          Double_t r=fb/fc;
+          q=fa/fc;
+          p=s*(2.*xm*q*(q-r)-(b-a)*(r-1.));
+          q=(q-1.)*(r-1.)*(s-1.);
+          }
+        if(p>0) q=-q;
+        p=fabs(p);
+        if(2.*p<std::min(3.*xm*q-fabs(tol1*q), fabs(e*q))){
+          e=d;
+          d=p/q;
+          }
+        else{
+          d=xm;
+          e=d;
+          }
+        }
+      else{
+        d=xm;
+        e=d;
+        }
+      a=b;
+      fa=fb;
+      b+=(fabs(d)>tol1) ? d : (xm>0 ? tol1 : -tol1);
+      fb=f(b);
+      if(std::isnan(fb)){
+        root=b;
+        froot=fb;
+        nIter++;
+        return 3;
+        }
+      }
+    root=b;
+    froot=fb;
+    return 2;
+  }
+
+}; // namespace
+
+#endif
@@ -73,15 +73,27 @@ typedef  float MAT[MMAX+2][MMAX+2]; // Matrix
      *  @param nl number of points on the left of the smoothing window
      *  @param nr number of points on the right of the smoothing window
      *  @param m smoothing polynome degree
+     *  @param ld order of the derivative, 0 for smoothing,
+     *         1 for the first derivative per point
      */
-    void CalculateCoefficients(int nl, int nr, int m);
+    void CalculateCoefficients(int nl, int nr, int m, int ld=0);
+
+    /** @brief Return the coefficient of the point at offset k
+     *  from the current one, once calculated
+     *
+     *  @param k offset from -nl to nr
+     */
+    float GetCoefficient(int k) const {
+		int np=NLeftPoints+NRightPoints+1;
+		return fCoeffs[((np-k) % np) + 1];
+		}
 
     /** @brief Print the Savitsky-Golay coefficients */
     void PrintCoefficients();
     
     // Get Output
     /** @brief Return the vector of mean values */
-    std::vector<float> GetMeanVec()     {return fMeanVec;} 
+    const std::vector<float>& GetMeanVec() const   {return fMeanVec;} 
 
 
   private:
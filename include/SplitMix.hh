@@ -0,0 +1,95 @@
+/** @file SplitMix.hh
+ *
+ * @brief Small random number generator with independent, reproducible
+ *  streams, for the Monte Carlo ensembles
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_SPLITMIX
+#define LIDARTOOLS_SPLITMIX
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <cmath>
+
+namespace LidarTools {
+
+ /** @class SplitMix64
+  *
+  * @brief SplitMix64 generator, Steele, Lea and Flood 2014
+  *
+  * The state is a 64 bit counter, each number is a bijective mix of it.
+  * A stream is seeded from a seed and a stream index, e.g. the replica
+  * number, so that the numbers of a replica do not depend on the thread
+  * that draws them, nor on the order of the replicas.
+  */
+  class SplitMix64
+  {
+
+  public:
+
+    /** @brief Constructor
+     *
+     * @param seed the seed, common to all streams
+     * @param stream the stream index
+     */
+    SplitMix64(ULong64_t seed, ULong64_t stream=0)
+      : fState(Mix(seed+Mix(stream+kGamma))), fHasGaus(false), fGaus(0) {}
+
+    /** @brief Return the next 64 bit number */
+    ULong64_t Next() {
+		fState+=kGamma;
+		return Mix(fState);
+		}
+
+    /** @brief Return a uniform number in ]0,1[ */
+    Double_t Uniform() {
+		// 53 bits, shifted by half a step so that 0 never comes out
+		return ((Next()>>11)+0.5)*(1./9007199254740992.);
+		}
+
+    /** @brief Return a standard normal number, polar Box-Muller */
+    Double_t Gaus() {
+		if(fHasGaus){
+		  fHasGaus=false;
+		  return fGaus;
+		  }
+		Double_t u, v, s;
+		do {
+		  u=2.*Uniform()-1.;
+		  v=2.*Uniform()-1.;
+		  s=u*u+v*v;
+		  } while(s>=1.);
+		Double_t f=sqrt(-2.*log(s)/s);
+		fGaus=v*f;
+		fHasGaus=true;
+		return u*f;
+		}
+
+    /** @brief Finalizer of SplitMix64, also to combine seeds
+     *
+     * @param z the value to mix
+     */
+    static ULong64_t Mix(ULong64_t z) {
+		z=(z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+		z=(z^(z>>27))*0x94D049BB133111EBULL;
+		return z^(z>>31);
+		}
+
+  private:
+    /** @brief Golden ratio increment */
+    static const ULong64_t kGamma=0x9E3779B97F4A7C15ULL;
+    /** @brief Counter */
+    ULong64_t fState;
+    /** @brief True if fGaus has not been returned yet */
+    Bool_t fHasGaus;
+    /** @brief Second number of the last Box-Muller pair */
+    Double_t fGaus;
+  }; // class
+
+}; // namespace
+
+#endif
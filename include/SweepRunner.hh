@@ -0,0 +1,160 @@
+/** @file SweepRunner.hh
+ *
+ * @brief SweepRunner class definition
+ *
+ * Process runs with every parameter set of a sweep, on a thread pool
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_SWEEPRUNNER
+#define LIDARTOOLS_SWEEPRUNNER
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <ctime>        // time_t
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ConfigHandler.hh"
+#include "LidarShot.hh"
+#include "SweepSpec.hh"
+
+namespace LidarTools {
+
+  class ThreadPool;
+
+/** @class SweepRunner
+ *
+ * @brief Process each run with each parameter set of a SweepSpec and
+ *  write one table of results
+ *
+ * Runs are read once, in the calling thread. The parameter sets are
+ * grouped by their shot preparation fingerprint: a task is a run with a
+ * group, it loads the shot once and processes it with each set of the
+ * group, so that the range, geometry, pre-scan and layers are shared.
+ * Tasks run on a work-stealing ThreadPool, one Analyser per worker.
+ *
+ * The configuration epochs of the base configuration are resolved for
+ * each run before the set parameters are applied, so the set parameters
+ * always win. Sets that do not compile, see AnalysisConfig::Compile, are
+ * skipped.
+ *
+ * The table has one row per run, set and wavelength, in this order, with
+ * the columns: run seq set wl rc verdict OD AOD R0 AC Sp fingerprint.
+ * The set names are listed in the header as "# set id name". When a run
+ * can not be loaded or a set applied, its rows have the return code,
+ * verdict -1, nan values and a fingerprint of zeros.
+ *
+ * @see SweepSpec ThreadPool::ParallelForStealing
+*/
+  class SweepRunner
+  {
+
+  public:
+    /** @brief class constructor
+     *
+     * @param nthreads the number of threads, 0 for the number of hardware threads
+     * @param verbose a boolean for verbosity
+     */
+    SweepRunner(Int_t nthreads=0, Bool_t verbose=false);
+
+    /** @brief class destructor, deletes the thread pool */
+    virtual ~SweepRunner();
+
+    /** @brief Read the base configuration, the default one otherwise
+     *
+     * @param filename the configuration file name
+     * @return 0 if OK, 1 if the file could not be read
+     */
+    int SetConfig(std::string filename);
+
+    /** @brief Set the parameter sets
+     *
+     * @param spec the sweep specification
+     */
+    void SetSpec(const SweepSpec& spec) {fSpec=spec;}
+
+    /** @brief Read a run from the standard HESS location
+     *
+     * @param runnumber the run number, e.g. 67220
+     * @return the LidarFile::Read return code
+     */
+    int AddRun(Int_t runnumber);
+
+    /** @brief Read a run from an ascii or ROOT file
+     *
+     * @param filename the file name
+     * @return the LidarFile::Read return code
+     */
+    int AddRun(std::string filename);
+
+    /** @brief Add a shot already in memory
+     *
+     * @param shot the raw data
+     * @param run the run number
+     * @param seq the sequence number
+     * @param time the time stamp as a time_t
+     */
+    void AddShot(std::shared_ptr<const LidarShot> shot,
+                 Int_t run=-99999, Int_t seq=1, time_t time=0);
+
+    /** @brief Process all runs with all sets and write the table
+     *
+     * @param outfile the output ascii file name
+     * @return 0 if OK, 1 if the output file could not be opened,
+     *         2 if no set compiled
+     */
+    int Run(std::string outfile);
+
+    /** @brief Set verbosity on or off
+     *
+     * @param verbose a bool, true or false
+     */
+    void SetVerbose(Bool_t verbose) {fVerbose=verbose;}
+
+    /** @brief Returns the base configuration */
+    ConfigHandler& GetConfig() {return fConfig;}
+
+    /** @brief Returns the number of runs */
+    Int_t GetNRuns() const {return fRuns.size();}
+
+  private:
+    /** @brief A run read in memory */
+    struct RunData
+    {
+      std::shared_ptr<const LidarShot> fShot;
+      Int_t  fRunNumber;
+      Int_t  fSeqNumber;
+      time_t fTime;
+    };
+
+    /** @brief boolean to print some results if true */
+    Bool_t fVerbose;
+
+    /** @brief Number of threads */
+    Int_t fNThreads;
+    /** @brief Thread pool, created by the first Run */
+    ThreadPool* fPool; //!
+
+    /** @brief Base configuration */
+    ConfigHandler fConfig;
+    /** @brief Parameter sets */
+    SweepSpec fSpec;
+    /** @brief Runs */
+    std::vector<RunData> fRuns; //!
+
+  protected:
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+    ClassDef(LidarTools::SweepRunner,1);
+#endif
+
+  }; // class
+
+}; // namespace
+
+#endif
@@ -0,0 +1,154 @@
+/** @file SweepSpec.hh
+ *
+ * @brief SweepSpec class definition
+ *
+ * Parameter sets of a sweep over configuration keys
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_SWEEPSPEC
+#define LIDARTOOLS_SWEEPSPEC
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace LidarTools {
+
+/** @class SweepSpec
+ *
+ * @brief Parameter sets, a grid over some keys, crossed with a list of
+ *  explicit sets
+ *
+ * A sweep file has the format of the configuration files. Keys outside
+ * sections are the grid axes, with comma separated values or a
+ * first:last:step range. Keys sharing an axis take the same value:
+ *
+ *     AlignCorr_355, AlignCorr_532 = 0:0.2:0.01
+ *     R0_355 = 8000, 10000, 12000
+ *
+ * Each section is an explicit set:
+ *
+ *     [Sp5070]
+ *     Fernald_Sp355 = 50
+ *     Fernald_Sp532 = 70
+ *
+ * The sets are every explicit set with every grid point, numbered with
+ * the explicit set first and the last axis fastest. Without explicit sets
+ * there is one empty set, the nominal configuration, crossed with the grid.
+ *
+ * @see SweepRunner
+*/
+  class SweepSpec
+  {
+
+  public:
+    /** @brief class constructor
+     *
+     * @param verbose a boolean for verbosity
+     */
+    SweepSpec(Bool_t verbose=false);
+
+    /** @brief class destructor */
+    virtual ~SweepSpec() {}
+
+    /** @brief Remove all axes and sets */
+    void Clear();
+
+    /** @brief Read a sweep file, adds to the current axes and sets
+     *
+     * @param filename the sweep file name
+     * @return 0 if OK, 1 if the file could not be opened, 2 for a bad range
+     */
+    int Read(std::string filename);
+
+    /** @brief Add a grid axis
+     *
+     * @param keys the parameter names, comma separated, all take the same value
+     * @param values the values, comma separated or first:last:step
+     * @return 0 if OK, 2 for a bad range
+     */
+    int AddAxis(std::string keys, std::string values);
+
+    /** @brief Add an explicit set
+     *
+     * @param name the set name
+     * @return the set index
+     */
+    Int_t AddSet(std::string name);
+
+    /** @brief Set a parameter of an explicit set
+     *
+     * @param set the explicit set index
+     * @param key the parameter name
+     * @param value the parameter value
+     */
+    void SetParam(Int_t set, std::string key, std::string value);
+
+    /** @brief Set verbosity on or off
+     *
+     * @param verbose a bool, true or false
+     */
+    void SetVerbose(Bool_t verbose) {fVerbose=verbose;}
+
+    /** @brief Returns the number of parameter sets */
+    Int_t GetNSets() const;
+
+    /** @brief Returns the parameters of a set
+     *
+     * @param id the set index, 0 to GetNSets()-1
+     */
+    std::map<std::string, std::string> GetSet(Int_t id) const;
+
+    /** @brief Returns the name of a set, the explicit set name and the
+     *  grid values, e.g. "Sp5070 R0_355=8000"
+     *
+     * @param id the set index, 0 to GetNSets()-1
+     */
+    std::string GetSetName(Int_t id) const;
+
+  private:
+    /** @brief A grid axis, keys sharing the same values */
+    struct Axis
+    {
+      std::vector<std::string> fKeys;
+      std::vector<std::string> fValues;
+    };
+
+    /** @brief An explicit set */
+    struct Set
+    {
+      std::string fName;
+      std::map<std::string, std::string> fParams;
+    };
+
+    /** @brief Returns the number of grid points */
+    Int_t GetNPoints() const;
+
+    /** @brief Value index on each axis of a grid point */
+    void GetPoint(Int_t point, std::vector<Int_t>& indices) const;
+
+    /** @brief boolean to print some results if true */
+    Bool_t fVerbose;
+
+    /** @brief Grid axes */
+    std::vector<Axis> fAxes;
+    /** @brief Explicit sets */
+    std::vector<Set> fSets;
+
+  protected:
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+    ClassDef(LidarTools::SweepSpec,1);
+#endif
+
+  }; // class
+
+}; // namespace
+
+#endif
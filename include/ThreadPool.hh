@@ -0,0 +1,160 @@
+/** @file ThreadPool.hh
+ *
+ * @brief ThreadPool class definition
+ *
+ * Fixed set of worker threads running loops of independent tasks
+ *
+ * @author Johan Bregeon
+*/
+
+#ifndef LIDARTOOLS_THREADPOOL
+#define LIDARTOOLS_THREADPOOL
+
+#if defined(USE_ROOT) || defined(ROOT_VERSION_CODE)
+#include <TROOT.h>
+#endif
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+namespace LidarTools {
+
+ /** @class ThreadPool
+  *
+  * @brief Worker threads created once and reused for each parallel loop
+  *
+  * ParallelFor hands out chunks of task indices from a shared counter.
+  * The calling thread is worker 0 and takes part in the loop, the pool
+  * owns the other GetNThreads()-1 threads. Tasks get their worker index,
+  * so that each worker can write to its own scratch memory.
+  *
+  * ParallelForStealing instead gives each worker a contiguous range of
+  * tasks, and a worker that ran out of tasks steals half of the range
+  * left to another one. Neighbouring tasks mostly run on the same worker,
+  * which suits tasks of very different costs sharing data with their
+  * neighbours.
+  *
+  * One loop at a time: ParallelFor must not be called from a task, nor
+  * from two threads at once.
+  */
+  class ThreadPool
+  {
+
+  public:
+
+    /** @brief Task of a loop, called with the task and worker indices */
+    typedef std::function<void(Int_t, Int_t)> Task;
+
+    /** @brief Constructor
+     *
+     * @param nthreads the number of threads including the caller,
+     *  0 for the number of hardware threads
+     */
+    ThreadPool(Int_t nthreads=0);
+
+    /** @brief Destructor, joins the threads
+     *
+     */
+    virtual ~ThreadPool();
+
+    /** @brief Run task(i, worker) for i in [0, n), returns once all are done
+     *
+     * @param n the number of tasks
+     * @param chunk the number of consecutive tasks taken at once
+     * @param task the task
+     */
+    void ParallelFor(Int_t n, Int_t chunk, const Task& task);
+
+    /** @brief Run task(i, worker) for i in [0, n) with work stealing,
+     *  returns once all are done
+     *
+     * @param n the number of tasks
+     * @param task the task
+     */
+    void ParallelForStealing(Int_t n, const Task& task);
+
+    /** @brief Return the number of threads, including the caller */
+    Int_t GetNThreads() const {return fNThreads;}
+
+    /** @brief Return the number of threads of a pool built with nthreads,
+     *  the number of hardware threads for 0
+     *
+     * @param nthreads the number of threads given to the constructor
+     */
+    static Int_t ResolveNThreads(Int_t nthreads);
+
+  private:
+
+    /** @brief not copyable */
+    ThreadPool(const ThreadPool&);
+    /** @brief not copyable */
+    ThreadPool& operator=(const ThreadPool&);
+
+    /** @brief Tasks [fFirst, fLast) left to a worker of a stealing loop */
+    struct Range
+    {
+      std::mutex fMutex;
+      Int_t      fFirst;
+      Int_t      fLast;
+    };
+
+    /** @brief Start a loop on the pool threads, run it and wait for them */
+    void RunLoop(Int_t n, Int_t chunk, Bool_t stealing, const Task& task);
+
+    /** @brief Loop of the pool threads, wait for a loop and run it */
+    void WorkerLoop(Int_t worker);
+
+    /** @brief Take chunks of the current loop until none is left */
+    void RunChunks(Int_t worker);
+
+    /** @brief Run the own tasks, then stolen ones, until none is left */
+    void RunStealing(Int_t worker);
+
+    /** @brief Take the next own task, false if none is left */
+    Bool_t PopTask(Int_t worker, Int_t& task);
+
+    /** @brief Steal half of the tasks left to another worker, false if none is left
+     *
+     * @param worker the thief
+     * @param task the first stolen task, the others go to the thief range
+     */
+    Bool_t StealTask(Int_t worker, Int_t& task);
+
+    /** @brief Number of threads, including the caller */
+    Int_t fNThreads;
+    /** @brief Pool threads, workers 1 to fNThreads-1 */
+    std::vector<std::thread> fThreads;
+    /** @brief Protects the loop state below */
+    std::mutex fMutex;
+    /** @brief Signals a new loop or the end of the pool */
+    std::condition_variable fWake;
+    /** @brief Signals that the pool threads are done with the loop */
+    std::condition_variable fDone;
+    /** @brief Task of the current loop */
+    const Task* fTask;
+    /** @brief Number of tasks of the current loop */
+    Int_t fN;
+    /** @brief Chunk size of the current loop */
+    Int_t fChunk;
+    /** @brief Next task index to hand out */
+    std::atomic<Int_t> fNext;
+    /** @brief True if the current loop steals work */
+    Bool_t fStealing;
+    /** @brief Task ranges of the workers of a stealing loop */
+    std::unique_ptr<Range[]> fRanges;
+    /** @brief Pool threads still in the current loop */
+    Int_t fNBusy;
+    /** @brief Loop counter, a thread runs each loop once */
+    ULong64_t fGeneration;
+    /** @brief True when the pool is destroyed */
+    Bool_t fStop;
+  }; // class
+
+}; // namespace
+
+#endif
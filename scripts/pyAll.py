@@ -8,7 +8,7 @@ ROOT.gROOT.SetBatch(1)
 ROOT.gStyle.SetCanvasColor(0)
 ROOT.gStyle.SetStatBorderSize(1)
 
-def runAnalysis(filename, outdir='./', Sp355='50', Sp532='50'):
+def runAnalysis(filename, outdir='./', Sp355='50', Sp532='50', cache=None):
     run=filename.split('run_')[1].split('_')[0]
     seq=filename.split('Lidar_')[1][:3]
     print('Processing %s'%filename)    
@@ -16,6 +16,9 @@ def runAnalysis(filename, outdir='./', Sp355='50', Sp532='50'):
     p = ROOT.LidarTools.LidarProcessor(filename, False)    
     rc=p.Init()
     if rc==0:
+        # runs already done with the same data and configuration are copied
+        if cache is not None:
+            p.SetCache(cache)
         p.OverwriteConfigParam("LidarTheta","15")
         p.OverwriteConfigParam("NBins","100")
         p.OverwriteConfigParam("LogBins","0")
@@ -43,12 +46,17 @@ def runAnalysis(filename, outdir='./', Sp355='50', Sp532='50'):
         arc=p.Process(True, True)
         if arc == 0:
             p.SaveAs(os.path.join(outdir,"analysis_"+run+"_"+seq+".root"))
+        elif p.IsRejected():
+            p.SaveAs(os.path.join(outdir,"rejected_"+run+"_"+seq+".root"))
         return arc
     
 
-def processAll(outdir, Sp355='50', Sp532='70', aboverun=0):
+def processAll(outdir, Sp355='50', Sp532='70', aboverun=0, cachedir=None, cachegb=0):
     if not os.path.exists(outdir):
         os.mkdir(outdir)
+    cache=None
+    if cachedir is not None:
+        cache=ROOT.LidarTools.ResultCache(cachedir, int(cachegb*1e9))
 
     oldroot=glob.glob("/data/Hess/data/LidarData_2009_2010_ROOT/run_0*.root")
     root=glob.glob("/data/Hess/data/root_files/run_0*.root")
@@ -60,7 +68,7 @@ def processAll(outdir, Sp355='50', Sp532='70', aboverun=0):
     for fname in oldroot:
         run=int(fname.split('run_0')[1].split('_')[0])
         if run>=aboverun:
-            runAnalysis(fname, outdir, Sp355, Sp532)
+            runAnalysis(fname, outdir, Sp355, Sp532, cache)
             done.append(int(run))
 #    for fname in txt:
 #        run=int(fname.split('run_0')[1].split('_')[0])
@@ -73,6 +81,8 @@ def processAll(outdir, Sp355='50', Sp532='70', aboverun=0):
 #            runAnalysis(fname, outdir, Sp355, Sp532)
 #            done.append(int(run))
     print(len(done), ' runs processed')     
+    if cache is not None:
+        cache.PrintStats()
 
 def processOne(run, outdir, Sp355='50', Sp532='50'):
     root=glob.glob("/data/Hess/data/root_files/run_0"+str(run)+"*.root")